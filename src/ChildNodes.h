@@ -0,0 +1,350 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+
+namespace suffix_tree{
+
+    namespace suffix_tree_impl{
+        const size_t INVALID_INDEX = std::numeric_limits<size_t>::max();
+
+        /// Storage for child pointers of the inner node. Representation depends on the number of children:
+        ///  small  - sorted array of child indexes and array of children;
+        ///  sparse - occupancy bitmap (every word followed by rank of its first bit) and compressed array of children;
+        ///  dense  - array of children addressed by index and occupancy bitmap, used when fill passes DENSE_FILL_PERCENT.
+        /// Representation is switched by insert/erase, children are always kept in index order, so iteration
+        /// is a find-next over the occupancy bitmap in sparse and dense modes.
+        template<typename ChildNodeT>
+        class ChildNodes
+        {
+            enum Mode: uint8_t{
+                small_Mode = 0,
+                sparse_Mode,
+                dense_Mode
+            };
+
+            static constexpr size_t SMALL_MAX_COUNT = 8;
+            static constexpr size_t DENSE_FILL_PERCENT = 50;
+            static constexpr size_t SPARSE_FILL_PERCENT = 25;
+            static constexpr size_t WORD_BITS = 64;
+
+            typedef std::vector<ChildNodeT *> NodesT;
+            typedef std::vector<uint64_t> IndexesT;
+            typedef std::vector<std::pair<size_t, ChildNodeT *>> PairsT;
+
+        public:
+            ChildNodes():
+                count_(0), mode_(small_Mode)
+            {}
+
+            ChildNodes(const ChildNodes &) = delete;
+            ChildNodes &operator=(const ChildNodes &) = delete;
+
+            size_t size()const noexcept{return count_;}
+
+            bool empty()const noexcept{return 0 == count_;}
+
+            ChildNodeT *find(
+                    size_t index)const noexcept
+            {
+                switch(mode_){
+                    case dense_Mode:
+                        return (index < nodes_.size())? nodes_[index]: nullptr;
+                    case sparse_Mode:{
+                        size_t word = index / WORD_BITS;
+                        if(index_.size() <= 2*word)
+                            return nullptr;
+                        uint64_t bits = index_[2*word];
+                        uint64_t bit = 1ull << (index % WORD_BITS);
+                        if(0 == (bits & bit))
+                            return nullptr;
+                        return nodes_[index_[2*word + 1] + __builtin_popcountll(bits & (bit - 1))];
+                    }
+                    default:
+                        for(size_t i = 0; i < count_; ++i){
+                            if(index_[i] == index)
+                                return nodes_[i];
+                            if(index_[i] > index)
+                                break;
+                        }
+                }
+                return nullptr;
+            }
+
+            /// adds child, which is not stored yet; capacity is expected count of children at the level
+            void insert(
+                    size_t index,
+                    ChildNodeT *node,
+                    size_t capacity)
+            {
+                capacity = std::max(capacity, index + 1);
+                if(small_Mode == mode_){
+                    if(count_ < SMALL_MAX_COUNT){
+                        auto pos = std::lower_bound(std::begin(index_), std::end(index_), index) - std::begin(index_);
+                        index_.insert(std::begin(index_) + pos, index);
+                        nodes_.insert(std::begin(nodes_) + pos, node);
+                        ++count_;
+                        return;
+                    }
+                    rebuild(sparse_Mode, capacity);
+                }
+
+                if(sparse_Mode == mode_){
+                    insertSparse(index, node);
+                    if(count_*100 > capacity*DENSE_FILL_PERCENT)
+                        rebuild(dense_Mode, capacity);
+                    return;
+                }
+
+                if(nodes_.size() <= index){
+                    nodes_.resize(capacity, nullptr);
+                    index_.resize(wordsCount(capacity), 0);
+                }
+                nodes_[index] = node;
+                index_[index / WORD_BITS] |= 1ull << (index % WORD_BITS);
+                ++count_;
+            }
+
+            /// removes child from storage and returns it, returns nullptr if child doesn't exist
+            ChildNodeT *erase(
+                    size_t index)
+            {
+                ChildNodeT *node = nullptr;
+                switch(mode_){
+                    case dense_Mode:
+                        if(index >= nodes_.size() || nullptr == nodes_[index])
+                            return nullptr;
+                        node = nodes_[index];
+                        nodes_[index] = nullptr;
+                        index_[index / WORD_BITS] &= ~(1ull << (index % WORD_BITS));
+                        --count_;
+                        if(count_*100 < nodes_.size()*SPARSE_FILL_PERCENT)
+                            rebuild((count_ <= SMALL_MAX_COUNT/2)? small_Mode: sparse_Mode, nodes_.size());
+                        return node;
+                    case sparse_Mode:{
+                        size_t word = index / WORD_BITS;
+                        if(index_.size() <= 2*word)
+                            return nullptr;
+                        uint64_t bit = 1ull << (index % WORD_BITS);
+                        if(0 == (index_[2*word] & bit))
+                            return nullptr;
+                        size_t pos = index_[2*word + 1] + __builtin_popcountll(index_[2*word] & (bit - 1));
+                        node = nodes_[pos];
+                        nodes_.erase(std::begin(nodes_) + pos);
+                        index_[2*word] &= ~bit;
+                        for(size_t i = 2*word + 3; i < index_.size(); i += 2)
+                            --index_[i];
+                        --count_;
+                        if(count_ <= SMALL_MAX_COUNT/2)
+                            rebuild(small_Mode, 0);
+                        return node;
+                    }
+                    default:{
+                        auto it = std::lower_bound(std::begin(index_), std::end(index_), index);
+                        if(std::end(index_) == it || index != *it)
+                            return nullptr;
+                        auto pos = it - std::begin(index_);
+                        node = nodes_[pos];
+                        index_.erase(it);
+                        nodes_.erase(std::begin(nodes_) + pos);
+                        --count_;
+                        return node;
+                    }
+                }
+            }
+
+            /// prefetches memory which is read by find(index)
+            void prefetch(
+                    size_t index)const noexcept
+            {
+                switch(mode_){
+                    case dense_Mode:
+                        if(index < nodes_.size())
+                            __builtin_prefetch(nodes_.data() + index);
+                        break;
+                    case sparse_Mode:
+                        if(2*(index / WORD_BITS) < index_.size())
+                            __builtin_prefetch(index_.data() + 2*(index / WORD_BITS));
+                        break;
+                    default:
+                        __builtin_prefetch(index_.data());
+                }
+            }
+
+            /// returns index of the next child after index
+            size_t next(
+                    size_t index)const noexcept
+            {
+                if(INVALID_INDEX == index)
+                    return INVALID_INDEX;
+                return nextFrom(index + 1);
+            }
+
+            /// returns index of the first child
+            size_t first()const noexcept
+            {
+                return nextFrom(0);
+            }
+
+            /// calls func(index, child) for all children in index order
+            template<typename FuncT>
+            void forEach(
+                    FuncT func)const
+            {
+                switch(mode_){
+                    case dense_Mode:
+                        for(size_t word = 0; word < index_.size(); ++word){
+                            uint64_t bits = index_[word];
+                            while(0 != bits){
+                                size_t index = word*WORD_BITS + __builtin_ctzll(bits);
+                                func(index, nodes_[index]);
+                                bits &= bits - 1;
+                            }
+                        }
+                        break;
+                    case sparse_Mode:{
+                        size_t pos = 0;
+                        for(size_t word = 0; 2*word < index_.size(); ++word){
+                            uint64_t bits = index_[2*word];
+                            while(0 != bits){
+                                func(word*WORD_BITS + __builtin_ctzll(bits), nodes_[pos++]);
+                                bits &= bits - 1;
+                            }
+                        }
+                        break;
+                    }
+                    default:
+                        for(size_t i = 0; i < count_; ++i)
+                            func(index_[i], nodes_[i]);
+                }
+            }
+
+            /// forgets all children, they have to be destroyed by owner
+            void clear()noexcept
+            {
+                NodesT tmpNodes;
+                IndexesT tmpIndexes;
+                std::swap(tmpNodes, nodes_);
+                std::swap(tmpIndexes, index_);
+                count_ = 0;
+                mode_ = small_Mode;
+            }
+
+        private:
+            size_t nextFrom(
+                    size_t index)const noexcept
+            {
+                switch(mode_){
+                    case dense_Mode:
+                        return findNextBit(index, 1);
+                    case sparse_Mode:
+                        return findNextBit(index, 2);
+                    default:
+                        for(size_t i = 0; i < count_; ++i){
+                            if(index_[i] >= index)
+                                return index_[i];
+                        }
+                }
+                return INVALID_INDEX;
+            }
+
+            /// bitmap words are placed in index_ with given step
+            size_t findNextBit(
+                    size_t index,
+                    size_t step)const noexcept
+            {
+                size_t word = index / WORD_BITS;
+                if(index_.size() <= step*word)
+                    return INVALID_INDEX;
+                uint64_t bits = index_[step*word] & (~0ull << (index % WORD_BITS));
+                while(0 == bits){
+                    ++word;
+                    if(index_.size() <= step*word)
+                        return INVALID_INDEX;
+                    bits = index_[step*word];
+                }
+                return word*WORD_BITS + __builtin_ctzll(bits);
+            }
+
+            static size_t wordsCount(
+                    size_t bits)noexcept
+            {
+                return (bits + WORD_BITS - 1) / WORD_BITS;
+            }
+
+            void insertSparse(
+                    size_t index,
+                    ChildNodeT *node)
+            {
+                size_t word = index / WORD_BITS;
+                if(index_.size() <= 2*word){
+                    size_t oldSize = index_.size();
+                    index_.resize(2*(word + 1), 0);
+                    for(size_t i = oldSize + 1; i < index_.size(); i += 2)
+                        index_[i] = count_;
+                }
+                uint64_t bit = 1ull << (index % WORD_BITS);
+                size_t pos = index_[2*word + 1] + __builtin_popcountll(index_[2*word] & (bit - 1));
+                nodes_.insert(std::begin(nodes_) + pos, node);
+                index_[2*word] |= bit;
+                for(size_t i = 2*word + 3; i < index_.size(); i += 2)
+                    ++index_[i];
+                ++count_;
+            }
+
+            void rebuild(
+                    Mode mode,
+                    size_t capacity)
+            {
+                PairsT children;
+                children.reserve(count_);
+                forEach([&](size_t index, ChildNodeT *node){children.emplace_back(index, node);});
+                size_t count = count_;
+                clear();
+
+                mode_ = mode;
+                count_ = count;
+                if(dense_Mode == mode){
+                    size_t size = children.empty()? capacity: std::max(capacity, children.back().first + 1);
+                    nodes_.assign(size, nullptr);
+                    index_.assign(wordsCount(size), 0);
+                    for(auto &val: children){
+                        nodes_[val.first] = val.second;
+                        index_[val.first / WORD_BITS] |= 1ull << (val.first % WORD_BITS);
+                    }
+                    return;
+                }
+
+                nodes_.reserve(children.size());
+                for(auto &val: children)
+                    nodes_.push_back(val.second);
+                if(small_Mode == mode){
+                    index_.reserve(children.size());
+                    for(auto &val: children)
+                        index_.push_back(val.first);
+                    return;
+                }
+
+                size_t words = children.empty()? 0: children.back().first / WORD_BITS + 1;
+                index_.assign(2*words, 0);
+                size_t rank = 0;
+                for(size_t word = 0, pos = 0; word < words; ++word){
+                    index_[2*word + 1] = rank;
+                    for(; pos < children.size() && children[pos].first / WORD_BITS == word; ++pos, ++rank)
+                        index_[2*word] |= 1ull << (children[pos].first % WORD_BITS);
+                }
+            }
+
+        private:
+            NodesT nodes_;
+            IndexesT index_;
+            uint32_t count_;
+            Mode mode_;
+        };
+
+    }
+
+}
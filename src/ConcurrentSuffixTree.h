@@ -0,0 +1,338 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <cstdint>
+
+#include "EpochReclaimer.h"
+#include "ShardedCounter.h"
+#include "SuffixTreeImpl.h"
+
+namespace suffix_tree{
+
+    namespace suffix_tree_impl{
+
+        struct ConcurrentNodeHeader{
+            explicit ConcurrentNodeHeader(size_t level):
+                level_(level)
+            {}
+
+            size_t level_;
+        };
+
+    }
+
+    /// Suffix tree for concurrent writers and readers.
+    /// Child slots and leaf presence words are published with release stores, so readers walk the
+    /// tree without locks and never wait for writers. Nodes unlinked by erase()/clear() are
+    /// retired to EpochReclaimer and freed when no reader can reach them anymore.
+    /// insert() can be called by many threads at once: missing nodes are installed with CAS and
+    /// presence bits are set with fetch_or. erase(), clear() and reclaim() remove nodes, so they
+    /// have to be called by one thread, while no insert() is running.
+    /// Subkey dictionaries of traits are not modified by the tree: keys with unknown subkeys are
+    /// rejected by insert(), so traits have to be filled before the tree is shared.
+    template<class ContTraitsT>
+    class ConcurrentSuffixTree
+    {
+    public:
+        typedef ContTraitsT TraitsT;
+        typedef typename TraitsT::KeyT KeyT;
+        typedef typename TraitsT::KeyViewT KeyViewT;
+        typedef typename TraitsT::ParsedKeyT ParsedKeyT;
+        typedef typename TraitsT::ValueT ValueT;
+        typedef ConcurrentSuffixTree<ContTraitsT> ThisTypeT;
+
+        static_assert(std::is_trivially_copyable<ValueT>::value,
+                      "ConcurrentSuffixTree: value has to be trivially copyable to be stored atomically");
+        /// larger values would take a hidden lock of libatomic, so readers could wait for writers
+        static_assert(std::atomic<ValueT>::is_always_lock_free,
+                      "ConcurrentSuffixTree: atomic value has to be lock free");
+
+    private:
+        typedef suffix_tree_impl::ConcurrentNodeHeader NodeHeaderT;
+        static constexpr size_t LEAF_LEVEL = ContTraitsT::SuffixLevel::leaf_Suffix;
+        static constexpr size_t WORD_BITS = 64;
+
+        struct InnerNodeT: NodeHeaderT{
+            InnerNodeT(size_t level, size_t count):
+                NodeHeaderT(level), children_(new std::atomic<NodeHeaderT *>[count]()), used_(0)
+            {}
+
+            std::unique_ptr<std::atomic<NodeHeaderT *>[]> children_;
+            std::atomic<size_t> used_; ///used by writers only
+        };
+
+        struct LeafNodeT: NodeHeaderT{
+            explicit LeafNodeT(size_t count):
+                NodeHeaderT(LEAF_LEVEL),
+                values_(new std::atomic<ValueT>[count]()),
+                presence_(new std::atomic<uint64_t>[(count + WORD_BITS - 1) / WORD_BITS]()),
+                used_(0)
+            {}
+
+            std::unique_ptr<std::atomic<ValueT>[]> values_;
+            std::unique_ptr<std::atomic<uint64_t>[]> presence_;
+            std::atomic<size_t> used_; ///used by writers only
+        };
+
+    public:
+        /// reader handle, has to be created and used by the single reader thread
+        class Reader{
+        public:
+            explicit Reader(const ConcurrentSuffixTree &tree):
+                tree_(tree), slot_(tree.reclaimer_.registerReader())
+            {}
+
+            ~Reader()
+            {
+                tree_.reclaimer_.unregisterReader(slot_);
+            }
+
+            Reader(const Reader &) = delete;
+            Reader &operator=(const Reader &) = delete;
+
+            bool find(
+                    KeyViewT key,
+                    ValueT &val)const
+            {
+                ParsedKeyT parsedKey;
+                if(!tree_.traits_.parseKey(key, parsedKey))
+                    return false;
+                return find(parsedKey, val);
+            }
+
+            bool find(
+                    const ParsedKeyT &parsedKey,
+                    ValueT &val)const
+            {
+                tree_.reclaimer_.enter(slot_);
+                bool res = tree_.find(parsedKey, val);
+                tree_.reclaimer_.leave(slot_);
+                return res;
+            }
+
+        private:
+            const ConcurrentSuffixTree &tree_;
+            size_t slot_;
+        };
+
+    public:
+        explicit ConcurrentSuffixTree(
+                const TraitsT &traits,
+                size_t maxReaders = 64):
+            traits_(traits),
+            reclaimer_(maxReaders),
+            root_(new InnerNodeT(0, traits_.suffixCount(static_cast<typename TraitsT::SuffixLevel>(0))))
+        {}
+
+        ~ConcurrentSuffixTree()
+        {
+            for(size_t i = 0; i < traits_.suffixCount(static_cast<typename TraitsT::SuffixLevel>(0)); ++i)
+                destroyNode(root_->children_[i].load(std::memory_order_relaxed));
+        }
+
+        ConcurrentSuffixTree(const ConcurrentSuffixTree &) = delete;
+        ConcurrentSuffixTree &operator=(const ConcurrentSuffixTree &) = delete;
+
+        /// returns true if the new key was added, value of the existing key is replaced
+        bool insert(
+                KeyViewT key,
+                const ValueT &val)
+        {
+            ParsedKeyT parsedKey;
+            if(!traits_.parseKey(key, parsedKey))
+                return false;
+            return insert(parsedKey, val);
+        }
+
+        bool insert(
+                const ParsedKeyT &parsedKey,
+                const ValueT &val)
+        {
+            if(!traits_.isValid(parsedKey))
+                return false;
+            NodeHeaderT *node = root_.get();
+            for(size_t level = 0; level < LEAF_LEVEL; ++level){
+                auto *inner = static_cast<InnerNodeT *>(node);
+                auto &slot = inner->children_[parsedKey[level]];
+                NodeHeaderT *child = slot.load(std::memory_order_acquire);
+                if(nullptr == child)
+                    child = installNode(inner, slot, level + 1);
+                node = child;
+            }
+
+            auto *leaf = static_cast<LeafNodeT *>(node);
+            size_t index = parsedKey[LEAF_LEVEL];
+            uint64_t mask = uint64_t(1) << (index % WORD_BITS);
+            leaf->values_[index].store(val, std::memory_order_relaxed);
+            if(0 != (leaf->presence_[index / WORD_BITS].fetch_or(mask, std::memory_order_release) & mask))
+                return false;
+            leaf->used_.fetch_add(1, std::memory_order_relaxed);
+            size_.add(1);
+            return true;
+        }
+
+        /// returns true if the key existed
+        bool erase(KeyViewT key)
+        {
+            ParsedKeyT parsedKey;
+            if(!traits_.parseKey(key, parsedKey))
+                return false;
+            return erase(parsedKey);
+        }
+
+        bool erase(const ParsedKeyT &parsedKey)
+        {
+            if(!traits_.isValid(parsedKey))
+                return false;
+            InnerNodeT *path[LEAF_LEVEL];
+            NodeHeaderT *node = root_.get();
+            for(size_t level = 0; level < LEAF_LEVEL; ++level){
+                path[level] = static_cast<InnerNodeT *>(node);
+                node = path[level]->children_[parsedKey[level]].load(std::memory_order_relaxed);
+                if(nullptr == node)
+                    return false;
+            }
+
+            auto *leaf = static_cast<LeafNodeT *>(node);
+            size_t index = parsedKey[LEAF_LEVEL];
+            auto &word = leaf->presence_[index / WORD_BITS];
+            uint64_t bits = word.load(std::memory_order_relaxed);
+            uint64_t mask = uint64_t(1) << (index % WORD_BITS);
+            if(0 == (bits & mask))
+                return false;
+            word.store(bits & ~mask, std::memory_order_release);
+            size_.add(-1);
+            if(1 == leaf->used_.fetch_sub(1, std::memory_order_relaxed))
+                prune(path, parsedKey);
+            return true;
+        }
+
+        /// writer side lookup, readers have to use Reader
+        bool find(
+                KeyViewT key,
+                ValueT &val)const
+        {
+            ParsedKeyT parsedKey;
+            if(!traits_.parseKey(key, parsedKey))
+                return false;
+            return find(parsedKey, val);
+        }
+
+        bool find(
+                const ParsedKeyT &parsedKey,
+                ValueT &val)const
+        {
+            if(!traits_.isValid(parsedKey))
+                return false;
+            const NodeHeaderT *node = root_.get();
+            for(size_t level = 0; level < LEAF_LEVEL; ++level){
+                node = static_cast<const InnerNodeT *>(node)->children_[parsedKey[level]].load(std::memory_order_acquire);
+                if(nullptr == node)
+                    return false;
+            }
+
+            auto *leaf = static_cast<const LeafNodeT *>(node);
+            size_t index = parsedKey[LEAF_LEVEL];
+            uint64_t bits = leaf->presence_[index / WORD_BITS].load(std::memory_order_acquire);
+            if(0 == (bits & (uint64_t(1) << (index % WORD_BITS))))
+                return false;
+            val = leaf->values_[index].load(std::memory_order_relaxed);
+            return true;
+        }
+
+        /// unlinks all nodes, they are freed when readers leave them
+        void clear()
+        {
+            for(size_t i = 0; i < traits_.suffixCount(static_cast<typename TraitsT::SuffixLevel>(0)); ++i){
+                NodeHeaderT *child = root_->children_[i].load(std::memory_order_relaxed);
+                if(nullptr == child)
+                    continue;
+                root_->children_[i].store(nullptr, std::memory_order_release);
+                reclaimer_.retire(child, &ThisTypeT::destroyNode);
+            }
+            root_->used_.store(0, std::memory_order_relaxed);
+            size_.reset();
+            reclaimer_.reclaim();
+        }
+
+        /// frees retired nodes, which aren't reachable by readers anymore
+        void reclaim()
+        {
+            reclaimer_.reclaim();
+        }
+
+        size_t size()const noexcept{return size_.load();}
+
+        const TraitsT &traits()const noexcept{return traits_;}
+
+    private:
+        NodeHeaderT *createNode(size_t level)
+        {
+            size_t count = traits_.suffixCount(static_cast<typename TraitsT::SuffixLevel>(level));
+            if(LEAF_LEVEL == level)
+                return new LeafNodeT(count);
+            return new InnerNodeT(level, count);
+        }
+
+        /// publishes the new node in the empty slot, if another writer was first its node is used
+        NodeHeaderT *installNode(
+                InnerNodeT *parent,
+                std::atomic<NodeHeaderT *> &slot,
+                size_t level)
+        {
+            NodeHeaderT *expected = nullptr;
+            NodeHeaderT *child = createNode(level);
+            if(slot.compare_exchange_strong(expected, child, std::memory_order_acq_rel, std::memory_order_acquire)){
+                parent->used_.fetch_add(1, std::memory_order_relaxed);
+                return child;
+            }
+            destroyNode(child);
+            return expected;
+        }
+
+        /// unlinks empty nodes bottom up, root is never removed
+        void prune(
+                InnerNodeT *const *path,
+                const ParsedKeyT &parsedKey)
+        {
+            for(size_t level = LEAF_LEVEL; level > 0; --level){
+                InnerNodeT *parent = path[level - 1];
+                auto &slot = parent->children_[parsedKey[level - 1]];
+                NodeHeaderT *child = slot.load(std::memory_order_relaxed);
+                slot.store(nullptr, std::memory_order_release);
+                reclaimer_.retire(child, &ThisTypeT::destroyNode);
+                if(1 != parent->used_.fetch_sub(1, std::memory_order_relaxed) || 1 == level)
+                    break;
+            }
+        }
+
+        static void destroyNode(void *ptr)
+        {
+            auto *node = static_cast<NodeHeaderT *>(ptr);
+            if(nullptr == node)
+                return;
+            if(LEAF_LEVEL == node->level_){
+                delete static_cast<LeafNodeT *>(node);
+                return;
+            }
+            auto *inner = static_cast<InnerNodeT *>(node);
+            for(size_t i = 0, used = inner->used_.load(std::memory_order_relaxed); 0 != used; ++i){
+                NodeHeaderT *child = inner->children_[i].load(std::memory_order_relaxed);
+                if(nullptr == child)
+                    continue;
+                destroyNode(child);
+                --used;
+            }
+            delete inner;
+        }
+
+    private:
+        TraitsT traits_;
+        mutable EpochReclaimer reclaimer_;
+        std::unique_ptr<InnerNodeT> root_;
+        suffix_tree_impl::ShardedCounter size_;
+    };
+
+}
@@ -1,45 +1,153 @@
 #pragma once
 
-//#include "SuffixTree.h"
+#include <memory>
+#include <functional>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <algorithm>
 
 namespace suffix_tree{
     namespace suffix_tree_impl{
 
-        template<typename MetaT, typename AlloctT, typename MetaT::SuffixLevel level>
-        class NodeAllocator{
-            typedef NodeAllocator<MetaT, AlloctT, level> ThisT;
-            typedef typename MetaT::template NodeTraits<AlloctT, level>::NodeTypeT NodeT;
+        /// Slab pool for nodes of one type: nodes are placed into contiguous chunks,
+        /// create/destroy are O(1) (bump pointer or free list) and clear() releases
+        /// all chunks at once.
+        template<typename NodeT>
+        class NodeAllocatorEx{
+            union SlotT{
+                SlotT *next_;
+                alignas(NodeT) char node_[sizeof(NodeT)];
+            };
+            typedef std::unique_ptr<SlotT[]> ChunkT;
+            typedef std::vector<ChunkT> ChunksT;
+
+            static constexpr size_t MAX_CHUNK_SIZE = 4096;
 
         public:
             typedef std::unique_ptr<NodeT, std::function<void(NodeT*)>> NodePtrT;
 
-            explicit NodeAllocator(size_t reserveSize = 100): allocNode_()
+            explicit NodeAllocatorEx(size_t reserveSize = 100):
+                    freeList_(nullptr), nextSlot_(nullptr), slotsLeft_(0),
+                    initChunkSize_(std::max<size_t>(reserveSize, 1)), chunkSize_(initChunkSize_),
+                    allocated_(0)
+            {
+            }
+
+            ~NodeAllocatorEx()
             {
+                clear();
             }
 
+            NodeAllocatorEx(const NodeAllocatorEx &) = delete;
+            NodeAllocatorEx &operator=(const NodeAllocatorEx &) = delete;
+
             template <class... Args>
             NodeT *create(Args&&... args) {
-                NodeT *ptr = allocNode_.allocate(1);
-                allocNode_.construct(ptr, std::forward<Args>(args)...);
-                return ptr;
+                SlotT *slot = allocateSlot();
+                try{
+                    return new (slot->node_) NodeT(std::forward<Args>(args)...);
+                }catch(...){
+                    releaseSlot(slot);
+                    throw;
+                }
             }
 
             template <class... Args>
             NodePtrT make_unique(Args&&... args) {
-                NodeT *ptr = allocNode_.allocate(1);
-                allocNode_.construct(ptr, std::forward<Args>(args)...);
-                return NodePtrT(ptr, [this](NodeT *node){this->destroy(node);});
+                return NodePtrT(create(std::forward<Args>(args)...), [this](NodeT *node){this->destroy(node);});
             }
 
             void destroy(NodeT * ptr) noexcept {
                 if(nullptr == ptr)
                     return;
-                allocNode_.destroy(ptr);
-                allocNode_.deallocate(ptr, 1);
+                ptr->~NodeT();
+                releaseSlot(reinterpret_cast<SlotT *>(ptr));
+            }
+
+            /// releases all chunks, nodes have to be destroyed before
+            void clear() noexcept
+            {
+                ChunksT tmp;
+                std::swap(tmp, chunks_);
+                freeList_ = nullptr;
+                nextSlot_ = nullptr;
+                slotsLeft_ = 0;
+                chunkSize_ = initChunkSize_;
+                allocated_ = 0;
+            }
+
+            size_t allocated()const noexcept{return allocated_;}
+
+            /// takes chunks of other pool, nodes created by other can be destroyed by this pool afterwards
+            void adopt(NodeAllocatorEx &other)
+            {
+                if(this == &other)
+                    return;
+                chunks_.reserve(chunks_.size() + other.chunks_.size());
+                for(auto &chunk: other.chunks_)
+                    chunks_.push_back(std::move(chunk));
+                for(; 0 != other.slotsLeft_; --other.slotsLeft_)
+                    pushFree(other.nextSlot_++);
+                while(nullptr != other.freeList_){
+                    SlotT *slot = other.freeList_;
+                    other.freeList_ = slot->next_;
+                    pushFree(slot);
+                }
+                allocated_ += other.allocated_;
+                other.chunks_.clear();
+                other.clear();
+            }
+
+        private:
+            SlotT *allocateSlot()
+            {
+                ++allocated_;
+                if(nullptr != freeList_){
+                    SlotT *slot = freeList_;
+                    freeList_ = slot->next_;
+                    return slot;
+                }
+                if(0 == slotsLeft_){
+                    chunks_.reserve(chunks_.size() + 1);
+                    chunks_.emplace_back(new SlotT[chunkSize_]);
+                    nextSlot_ = chunks_.back().get();
+                    slotsLeft_ = chunkSize_;
+                    chunkSize_ = std::min(chunkSize_*2, std::max(MAX_CHUNK_SIZE, initChunkSize_));
+                }
+                --slotsLeft_;
+                return nextSlot_++;
+            }
+
+            void releaseSlot(SlotT *slot) noexcept
+            {
+                --allocated_;
+                pushFree(slot);
+            }
+
+            void pushFree(SlotT *slot) noexcept
+            {
+                slot->next_ = freeList_;
+                freeList_ = slot;
             }
 
         private:
-            std::allocator<NodeT> allocNode_;
+            ChunksT chunks_;
+            SlotT *freeList_;
+            SlotT *nextSlot_;
+            size_t slotsLeft_;
+            size_t initChunkSize_;
+            size_t chunkSize_;
+            size_t allocated_;
+        };
+
+        template<typename MetaT, typename AlloctT, typename MetaT::SuffixLevel level>
+        class NodeAllocator: public NodeAllocatorEx<typename MetaT::template NodeTraits<AlloctT, level>::NodeTypeT>{
+            typedef NodeAllocatorEx<typename MetaT::template NodeTraits<AlloctT, level>::NodeTypeT> BaseT;
+        public:
+            explicit NodeAllocator(size_t reserveSize = 100): BaseT(reserveSize)
+            {
+            }
         };
 
         template<typename MetaT, enum MetaT::SuffixLevel level>
@@ -84,42 +192,69 @@ namespace suffix_tree{
             }
         };
 
-        template<typename NodeT>
-        class NodeAllocatorEx{
+        /// Set of slab pools, one per node level below the root
+        template<typename MetaT>
+        class LevelNodeAllocators{
+            typedef typename MetaT::SuffixLevel SuffixLevel;
+
+            template<typename IdxSeqT>
+            struct PoolsOf;
+
+            template<size_t... LevelsT>
+            struct PoolsOf<std::index_sequence<LevelsT...>>{
+                typedef std::tuple<NodeAllocatorEx<
+                        typename MetaT::template NodeTraits<static_cast<SuffixLevel>(LevelsT + 1)>::NodeTypeT>...> TypeT;
+            };
+
+            typedef typename PoolsOf<std::make_index_sequence<SuffixLevel::leaf_Suffix>>::TypeT PoolsT;
+
         public:
-            typedef std::unique_ptr<NodeT, std::function<void(NodeT*)>> NodePtrT;
+            template<SuffixLevel level>
+            using AllocatorT = NodeAllocatorEx<typename MetaT::template NodeTraits<level>::NodeTypeT>;
 
-            explicit NodeAllocatorEx(size_t reserveSize = 100): allocNode_()
+            LevelNodeAllocators() = default;
+            LevelNodeAllocators(const LevelNodeAllocators &) = delete;
+            LevelNodeAllocators &operator=(const LevelNodeAllocators &) = delete;
+
+            template<SuffixLevel level>
+            AllocatorT<level> &allocator() noexcept
             {
+                static_assert(SuffixLevel::root_Suffix < level && level <= SuffixLevel::leaf_Suffix);
+                return std::get<level - 1>(pools_);
             }
 
-            template <class... Args>
-            NodeT *create(Args&&... args) {
-                NodeT *ptr = allocNode_.allocate(1);
-                allocNode_.construct(ptr, std::forward<Args>(args)...);
-                return ptr;
+            /// pool of the node type, the same as allocator<level>() for the level of NodeT
+            template<typename NodeT>
+            NodeAllocatorEx<NodeT> &allocatorOf() noexcept
+            {
+                return std::get<NodeAllocatorEx<NodeT>>(pools_);
             }
 
-            template <class... Args>
-            NodePtrT make_unique(Args&&... args) {
-                NodeT *ptr = allocNode_.allocate(1);
-                allocNode_.construct(ptr, std::forward<Args>(args)...);
-                return NodePtrT(ptr, [this](NodeT *node){this->destroy(node);});
+            /// releases chunks of all levels, nodes have to be destroyed before
+            void clear() noexcept
+            {
+                std::apply([](auto&... pool){(pool.clear(), ...);}, pools_);
             }
 
-            void destroy(NodeT * ptr) noexcept {
-                if(nullptr == ptr)
-                    return;
-                allocNode_.destroy(ptr);
-                allocNode_.deallocate(ptr, 1);
+            /// takes chunks of all levels of other
+            void adopt(LevelNodeAllocators &other)
+            {
+                adoptPools(other, std::make_index_sequence<SuffixLevel::leaf_Suffix>());
             }
 
         private:
-            std::allocator<NodeT> allocNode_;
+            template<size_t... LevelsT>
+            void adoptPools(
+                    LevelNodeAllocators &other,
+                    std::index_sequence<LevelsT...>)
+            {
+                (std::get<LevelsT>(pools_).adopt(std::get<LevelsT>(other.pools_)), ...);
+            }
+
+        private:
+            PoolsT pools_;
         };
 
     }
 
 }
-
-
@@ -14,6 +14,7 @@ namespace{
     Key2IndexT toKey2IndexT(const Key2IdxT &vals, StringArena &storage)
     {
         Key2IndexT res;
+        res.reserve(vals.size());
         std::for_each(
                 std::begin(vals), std::end(vals),
                 [&](const KeyT &v)
@@ -34,6 +35,7 @@ ContBuilderKeys::ContBuilderKeys(size_t levelCount):
     for(size_t i = 0; i < levelCount; ++i){
         meta_.push_back(Key2IndexT());
     }
+    initLevels();
 }
 
 ContBuilderKeys::ContBuilderKeys(
@@ -44,6 +46,7 @@ ContBuilderKeys::ContBuilderKeys(
     meta_.reserve(2);
     meta_.emplace_back(toKey2IndexT(lvl1, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl2, stringAllocator_));
+    initLevels();
 }
 
 ContBuilderKeys::ContBuilderKeys(
@@ -56,6 +59,7 @@ ContBuilderKeys::ContBuilderKeys(
     meta_.emplace_back(toKey2IndexT(lvl1, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl2, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl3, stringAllocator_));
+    initLevels();
 }
 
 ContBuilderKeys::ContBuilderKeys(
@@ -70,6 +74,7 @@ ContBuilderKeys::ContBuilderKeys(
     meta_.emplace_back(toKey2IndexT(lvl2, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl3, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl4, stringAllocator_));
+    initLevels();
 }
 
 ContBuilderKeys::ContBuilderKeys(
@@ -86,6 +91,7 @@ ContBuilderKeys::ContBuilderKeys(
     meta_.emplace_back(toKey2IndexT(lvl3, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl4, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl5, stringAllocator_));
+    initLevels();
 }
 
 ContBuilderKeys::ContBuilderKeys(
@@ -104,6 +110,7 @@ ContBuilderKeys::ContBuilderKeys(
     meta_.emplace_back(toKey2IndexT(lvl4, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl5, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl6, stringAllocator_));
+    initLevels();
 }
 
 ContBuilderKeys::ContBuilderKeys(
@@ -124,6 +131,7 @@ ContBuilderKeys::ContBuilderKeys(
     meta_.emplace_back(toKey2IndexT(lvl5, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl6, stringAllocator_));
     meta_.emplace_back(toKey2IndexT(lvl7, stringAllocator_));
+    initLevels();
 }
 
 ContBuilderKeys::ContBuilderKeys(const ContBuilderKeys &keys):
@@ -134,13 +142,20 @@ ContBuilderKeys::ContBuilderKeys(const ContBuilderKeys &keys):
     {
         meta_.emplace_back(Key2IndexT());
         auto &level = meta_.back();
+        level.reserve(mit.size());
         for(auto &it: mit)
         {
             std::string_view valCpy = stringAllocator_.allocate(it.first);
             level[valCpy] = it.second;
         }
     }
-
+    initLevels();
+    for(size_t i = 0; i < meta_.size(); ++i){
+        if(keys.frozen_[i].built())
+            frozen_[i].build(meta_[i]);
+        if(keys.shortMode_[i])
+            enableShortKeys(i);
+    }
 }
 
 ContBuilderKeys &ContBuilderKeys::operator=(const ContBuilderKeys &cont)
@@ -149,6 +164,9 @@ ContBuilderKeys &ContBuilderKeys::operator=(const ContBuilderKeys &cont)
         return *this;
     ContBuilderKeys tmp(cont);
     std::swap(meta_, tmp.meta_);
+    std::swap(frozen_, tmp.frozen_);
+    std::swap(shortKeys_, tmp.shortKeys_);
+    std::swap(shortMode_, tmp.shortMode_);
     std::swap(stringAllocator_, tmp.stringAllocator_);
     return *this;
 }
@@ -166,6 +184,15 @@ const Key2IndexT &ContBuilderKeys::level(size_t level)const noexcept
     return meta_[level];
 }
 
+std::vector<KeyViewT> ContBuilderKeys::keys(size_t level)const
+{
+    assert(level < meta_.size());
+    std::vector<KeyViewT> res(meta_[level].size());
+    for(auto &val: meta_[level])
+        res[val.second] = val.first;
+    return res;
+}
+
 size_t ContBuilderKeys::addKey(size_t level, const KeyViewT &val)
 {
     assert(level < meta_.size());
@@ -173,5 +200,50 @@ size_t ContBuilderKeys::addKey(size_t level, const KeyViewT &val)
     size_t index = levelKeys.size();
     KeyViewT cpy = stringAllocator_.allocate(val);
     levelKeys[cpy] = index;
+    frozen_[level].clear();
+    if(shortMode_[level] && ShortKeyIndex::isShort(cpy))
+        shortKeys_[level].insert(cpy, index);
     return index;
+}
+
+bool ContBuilderKeys::freeze()
+{
+    bool res = true;
+    for(size_t i = 0; i < meta_.size(); ++i){
+        if(!frozen_[i].built() && !frozen_[i].build(meta_[i]))
+            res = false;
+    }
+    return res;
+}
+
+void ContBuilderKeys::initLevels()
+{
+    frozen_.resize(meta_.size());
+    shortKeys_.resize(meta_.size());
+    shortMode_.assign(meta_.size(), false);
+}
+
+void ContBuilderKeys::enableShortKeys(size_t level)
+{
+    assert(level < meta_.size());
+    if(shortMode_[level])
+        return;
+    for(auto &key: meta_[level]){
+        if(ShortKeyIndex::isShort(key.first))
+            shortKeys_[level].insert(key.first, key.second);
+    }
+    shortMode_[level] = true;
+}
+
+bool ContBuilderKeys::shortKeys(size_t level)const noexcept
+{
+    assert(level < meta_.size());
+    return shortMode_[level];
+}
+
+bool ContBuilderKeys::frozen()const noexcept
+{
+    return std::all_of(
+            std::begin(frozen_), std::end(frozen_),
+            [](const PerfectHashIndex &index){return index.built();});
 }
\ No newline at end of file
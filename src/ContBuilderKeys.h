@@ -5,17 +5,19 @@
 #pragma once
 
 #include "StringArena.h"
+#include "FlatKeyIndex.h"
+#include "PerfectHashIndex.h"
+#include "ShortKeyIndex.h"
 
 #include <string>
 #include <vector>
-#include <unordered_map>
 
 namespace aux {
 
     typedef std::string KeyT;
     typedef std::string_view KeyViewT;
     typedef std::vector<KeyT> Key2IdxT;
-    typedef std::unordered_map<KeyViewT, size_t> Key2IndexT;
+    typedef FlatKeyIndex Key2IndexT;
 
 
     class ContBuilderKeys{
@@ -66,12 +68,58 @@ namespace aux {
 
         const Key2IndexT &level(size_t level)const noexcept;
 
+        /// subkeys of the level ordered by index
+        std::vector<KeyViewT> keys(size_t level)const;
+
         size_t addKey(size_t level, const KeyViewT &val);
+
+        /// looks up index of subkey by perfect hash of the level if it is built,
+        /// short subkeys of the level in short keys mode are resolved by integer compares
+        bool getKeyIndex(
+                size_t level,
+                const KeyViewT &val,
+                size_t &index)const noexcept
+        {
+            if(frozen_[level].built())
+                return frozen_[level].find(val, index);
+            if(shortMode_[level] && ShortKeyIndex::isShort(val))
+                return shortKeys_[level].find(val, index);
+            auto it = meta_[level].find(val);
+            if(std::end(meta_[level]) == it)
+                return false;
+            index = it->second;
+            return true;
+        }
+
+        /// builds perfect hash for every level, addKey drops it for the modified level.
+        /// Returns false if hash of any level can't be built, such level is resolved by the flat map
+        bool freeze();
+
+        bool frozen()const noexcept;
+
+        /// keeps ShortKeyIndex of short subkeys of the level, it is used while the level is not frozen.
+        /// The level holds one more index, so the mode is for hot levels with changing dictionaries
+        void enableShortKeys(size_t level);
+
+        bool shortKeys(size_t level)const noexcept;
+
+    private:
+        /// creates per level indexes for keys stored in meta_
+        void initLevels();
+
     private:
         StringArena stringAllocator_;
 
         typedef std::vector<Key2IndexT> MetaDataPerLevelsT;
         MetaDataPerLevelsT meta_;
+
+        typedef std::vector<PerfectHashIndex> FrozenLevelsT;
+        FrozenLevelsT frozen_;
+
+        typedef std::vector<ShortKeyIndex> ShortKeysLevelsT;
+        /// filled for levels in short keys mode only
+        ShortKeysLevelsT shortKeys_;
+        std::vector<char> shortMode_;
     };
 
 }
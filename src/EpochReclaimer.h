@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+
+namespace suffix_tree{
+
+    /// Epoch based reclamation for single writer / multiple readers structures.
+    /// Reader registers once and marks every read section with enter()/leave(): it publishes
+    /// the global epoch it observed. Writer retires unlinked objects with the current epoch and
+    /// frees them when the global epoch is two steps ahead, i.e. every reader, which could see
+    /// them, has left its read section. Readers never wait for writer.
+    /// retire()/reclaim() have to be called from the writer thread only.
+    class EpochReclaimer{
+        static constexpr uint64_t INACTIVE_EPOCH = 0;
+        static constexpr size_t RECLAIM_THRESHOLD = 64;
+
+        struct alignas(64) SlotT{
+            std::atomic<uint64_t> epoch_{INACTIVE_EPOCH};
+            std::atomic<bool> used_{false};
+        };
+
+        typedef void (*DeleterT)(void *);
+        struct RetiredT{
+            void *ptr_;
+            DeleterT deleter_;
+            uint64_t epoch_;
+        };
+        typedef std::vector<RetiredT> RetiredListT;
+
+    public:
+        explicit EpochReclaimer(size_t maxReaders = 64):
+            slots_(new SlotT[maxReaders]), slotsCount_(maxReaders), globalEpoch_(1)
+        {}
+
+        ~EpochReclaimer()
+        {
+            for(auto &val: retired_)
+                val.deleter_(val.ptr_);
+        }
+
+        EpochReclaimer(const EpochReclaimer &) = delete;
+        EpochReclaimer &operator=(const EpochReclaimer &) = delete;
+
+        /// returns slot of the new reader
+        size_t registerReader()
+        {
+            for(size_t i = 0; i < slotsCount_; ++i){
+                bool expected = false;
+                if(slots_[i].used_.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                    return i;
+            }
+            throw std::runtime_error("EpochReclaimer::registerReader: too many readers");
+        }
+
+        void unregisterReader(size_t slot)noexcept
+        {
+            slots_[slot].epoch_.store(INACTIVE_EPOCH, std::memory_order_release);
+            slots_[slot].used_.store(false, std::memory_order_release);
+        }
+
+        void enter(size_t slot)noexcept
+        {
+            slots_[slot].epoch_.store(globalEpoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+            /// epoch has to be visible before any pointer of the structure is read
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        void leave(size_t slot)noexcept
+        {
+            slots_[slot].epoch_.store(INACTIVE_EPOCH, std::memory_order_release);
+        }
+
+        /// ptr has to be unlinked from the structure already
+        template<typename T>
+        void retire(T *ptr)
+        {
+            retire(ptr, [](void *p){delete static_cast<T *>(p);});
+        }
+
+        void retire(
+                void *ptr,
+                DeleterT deleter)
+        {
+            retired_.push_back(RetiredT{ptr, deleter, globalEpoch_.load(std::memory_order_relaxed)});
+            if(retired_.size() >= RECLAIM_THRESHOLD)
+                reclaim();
+        }
+
+        /// tries to advance epoch and frees objects, which can't be reached by readers anymore
+        void reclaim()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            tryAdvance();
+            uint64_t epoch = globalEpoch_.load(std::memory_order_relaxed);
+            size_t kept = 0;
+            for(size_t i = 0; i < retired_.size(); ++i){
+                if(retired_[i].epoch_ + 2 <= epoch)
+                    retired_[i].deleter_(retired_[i].ptr_);
+                else
+                    retired_[kept++] = retired_[i];
+            }
+            retired_.resize(kept);
+        }
+
+        size_t retiredCount()const noexcept{return retired_.size();}
+
+    private:
+        void tryAdvance()noexcept
+        {
+            uint64_t epoch = globalEpoch_.load(std::memory_order_relaxed);
+            for(size_t i = 0; i < slotsCount_; ++i){
+                uint64_t readerEpoch = slots_[i].epoch_.load(std::memory_order_acquire);
+                if(INACTIVE_EPOCH != readerEpoch && epoch != readerEpoch)
+                    return;
+            }
+            globalEpoch_.store(epoch + 1, std::memory_order_release);
+        }
+
+    private:
+        std::unique_ptr<SlotT[]> slots_;
+        size_t slotsCount_;
+        std::atomic<uint64_t> globalEpoch_;
+        RetiredListT retired_;
+    };
+
+}
@@ -0,0 +1,28 @@
+#include "EytzingerIndex.h"
+
+#include <stdexcept>
+#include <limits>
+
+using namespace st_suffix_tree;
+
+EytzingerIndex::EytzingerIndex(const SortedKeysT &keys):
+    prefixes_(keys.size() + 1, 0),
+    positions_(keys.size() + 1, 0)
+{
+    if(keys.size() >= std::numeric_limits<PositionsT::value_type>::max())
+        throw std::runtime_error("EytzingerIndex::EytzingerIndex: too many keys");
+    build(keys, 0, 1);
+}
+
+size_t EytzingerIndex::build(
+        const SortedKeysT &keys,
+        size_t pos,
+        size_t k)
+{
+    if(k >= prefixes_.size())
+        return pos;
+    pos = build(keys, pos, 2*k);
+    prefixes_[k] = toPrefix(keys[pos]);
+    positions_[k] = static_cast<PositionsT::value_type>(pos);
+    return build(keys, pos + 1, 2*k + 1);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace st_suffix_tree{
+
+    /// Search index over sorted subkeys of one level. First 8 bytes of every subkey are packed
+    /// big-endian into an integer (integer order matches lexicographic order) and placed
+    /// in Eytzinger (BFS) order, so lower bound is a branchless descent with prefetch of
+    /// the levels below. Subkeys themselves are touched only by the final exact compare.
+    class EytzingerIndex{
+        typedef std::vector<uint64_t> PrefixesT;
+        typedef std::vector<uint32_t> PositionsT;
+
+        /// descendants of node k four levels below start at 16*k
+        static constexpr size_t PREFETCH_DISTANCE = 16;
+
+    public:
+        typedef std::string_view KeyViewT;
+        typedef std::vector<std::string> SortedKeysT;
+
+        EytzingerIndex() = default;
+
+        /// keys have to be sorted
+        explicit EytzingerIndex(const SortedKeysT &keys);
+
+        /// looks up exact key, keys have to be the same as passed to constructor;
+        /// index is position of key in keys
+        bool find(
+                KeyViewT key,
+                const SortedKeysT &keys,
+                size_t &index)const noexcept
+        {
+            size_t count = prefixes_.size() - 1;
+            uint64_t prefix = toPrefix(key);
+            const uint64_t *prefixes = prefixes_.data();
+            size_t k = 1;
+            while(k <= count){
+                __builtin_prefetch(prefixes + PREFETCH_DISTANCE*k);
+                k = 2*k + (prefixes[k] < prefix);
+            }
+            /// drop trailing right turns to get the lower bound
+            k >>= __builtin_ffsll(~k);
+            if(0 == k || prefixes[k] != prefix)
+                return false;
+            for(size_t pos = positions_[k]; pos < keys.size(); ++pos){
+                const std::string &val = keys[pos];
+                if(val.length() == key.length() && 0 == memcmp(val.data(), key.data(), key.length())){
+                    index = pos;
+                    return true;
+                }
+                if(toPrefix(val) != prefix)
+                    break;
+            }
+            return false;
+        }
+
+        static uint64_t toPrefix(
+                KeyViewT key)noexcept
+        {
+            uint64_t res = 0;
+            memcpy(&res, key.data(), std::min<size_t>(key.length(), sizeof(res)));
+            return __builtin_bswap64(res);
+        }
+
+    private:
+        size_t build(
+                const SortedKeysT &keys,
+                size_t pos,
+                size_t k);
+
+    private:
+        /// 1-based, element 0 is unused
+        PrefixesT prefixes_ = PrefixesT(1, 0);
+        PositionsT positions_ = PositionsT(1, 0);
+    };
+
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+#include "StaticSuffixTree.h"
+
+namespace st_suffix_tree{
+
+/// Cardinalities of levels known at compile time: FixedSuffixTree<Dims<26, 26, 26, 26>, ValueT>
+template<size_t... DimsT>
+struct Dims{
+    static constexpr bool PAD_POW2 = false;
+    static constexpr std::array<size_t, sizeof...(DimsT)> SIZES{{DimsT...}};
+};
+
+/// Same as Dims, but every level is padded to the power of two, so index is calculated by shifts
+template<size_t... DimsT>
+struct Pow2Dims{
+    static constexpr bool PAD_POW2 = true;
+    static constexpr std::array<size_t, sizeof...(DimsT)> SIZES{{DimsT...}};
+};
+
+namespace st_suffix_tree_impl{
+
+    constexpr size_t roundUpPow2(size_t val)
+    {
+        size_t res = 1;
+        while(res < val)
+            res <<= 1;
+        return res;
+    }
+
+    constexpr size_t fixedPaddedSize(
+            bool padPow2,
+            size_t size)
+    {
+        return padPow2? roundUpPow2(size): size;
+    }
+
+    template<typename DimsT>
+    constexpr std::array<size_t, DimsT::SIZES.size()> fixedStrides()
+    {
+        std::array<size_t, DimsT::SIZES.size()> res{};
+        size_t stride = 1;
+        for(size_t lvl = res.size(); lvl-- > 0;){
+            res[lvl] = stride;
+            stride *= fixedPaddedSize(DimsT::PAD_POW2, DimsT::SIZES[lvl]);
+        }
+        return res;
+    }
+
+    template<typename DimsT>
+    constexpr bool fixedValidDims()
+    {
+        for(size_t lvl = 0; lvl < DimsT::SIZES.size(); ++lvl){
+            if(0 == DimsT::SIZES[lvl])
+                return false;
+        }
+        return true;
+    }
+
+    /// Dense container with compile time dimensions: values and presence bits are stored
+    /// in std::array inside the object, index of the key is a sum of constant products.
+    /// Keys are pre-resolved subkey indexes. Object may be large, allocate it on the heap.
+    template<typename DimsT, typename ContValueT>
+    class FixedSuffixTree
+    {
+    public:
+        typedef ContValueT ValueT;
+        static constexpr size_t LEVELS_COUNT = DimsT::SIZES.size();
+        typedef std::array<size_t, LEVELS_COUNT> ParsedKeyT;
+        typedef FixedSuffixTree<DimsT, ContValueT> ThisTypeT;
+        typedef SuffixTreeIterator<ThisTypeT> Iterator;
+
+        friend Iterator;
+
+    private:
+        static constexpr size_t WORD_BITS = 64;
+
+        static constexpr ParsedKeyT STRIDES = fixedStrides<DimsT>();
+        static constexpr size_t TOTAL_SIZE = STRIDES[0]*fixedPaddedSize(DimsT::PAD_POW2, DimsT::SIZES[0]);
+        static constexpr size_t WORDS_COUNT = (TOTAL_SIZE + WORD_BITS - 1) / WORD_BITS;
+
+        static_assert(2 <= LEVELS_COUNT, "FixedSuffixTree: at least 2 levels are expected");
+        static_assert(fixedValidDims<DimsT>(), "FixedSuffixTree: level can't be empty");
+
+    public:
+        FixedSuffixTree():
+            size_(0)
+        {
+            values_.fill(ValueT());
+            presence_.fill(0);
+        }
+
+        static constexpr size_t capacity()noexcept{return TOTAL_SIZE;}
+
+        static constexpr bool isValid(const ParsedKeyT &key)noexcept
+        {
+            for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl){
+                if(key[lvl] >= DimsT::SIZES[lvl])
+                    return false;
+            }
+            return true;
+        }
+
+        static constexpr size_t calcIndex(const ParsedKeyT &key)noexcept
+        {
+            size_t index = 0;
+            for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl)
+                index += key[lvl]*STRIDES[lvl];
+            return index;
+        }
+
+        /// index of the key, which is checked at compile time
+        template<size_t... IdxT>
+        static constexpr size_t indexOf()noexcept
+        {
+            static_assert(sizeof...(IdxT) == LEVELS_COUNT, "FixedSuffixTree::indexOf: wrong count of subkeys");
+            static_assert(isValid(ParsedKeyT{{IdxT...}}), "FixedSuffixTree::indexOf: subkey is out of range");
+            return calcIndex(ParsedKeyT{{IdxT...}});
+        }
+
+        Iterator begin()const
+        {
+            return Iterator(this, nextFrom(0));
+        }
+
+        Iterator end()const
+        {
+            return Iterator();
+        }
+
+        Iterator insert(
+                const ParsedKeyT &key,
+                const ValueT &val)
+        {
+            if(!isValid(key))
+                return end();
+            return insertIndex(calcIndex(key), val);
+        }
+
+        template<size_t... IdxT>
+        Iterator insertAt(const ValueT &val)
+        {
+            return insertIndex(indexOf<IdxT...>(), val);
+        }
+
+        Iterator find(const ParsedKeyT &key)const
+        {
+            if(!isValid(key))
+                return end();
+            return findIndex(calcIndex(key));
+        }
+
+        template<size_t... IdxT>
+        Iterator findAt()const
+        {
+            return findIndex(indexOf<IdxT...>());
+        }
+
+        Iterator erase(const ParsedKeyT &key)
+        {
+            if(!isValid(key))
+                return end();
+            return eraseIndex(calcIndex(key));
+        }
+
+        Iterator erase(const Iterator &it)
+        {
+            if(end() == it)
+                return end();
+            return eraseIndex(it.index());
+        }
+
+        size_t size()const noexcept{return size_;}
+
+        void clear()
+        {
+            size_ = 0;
+            values_.fill(ValueT());
+            presence_.fill(0);
+        }
+
+    private:
+        Iterator insertIndex(
+                size_t index,
+                const ValueT &val)
+        {
+            values_[index] = val;
+            uint64_t &word = presence_[index / WORD_BITS];
+            uint64_t bit = 1ull << (index % WORD_BITS);
+            if(0 == (word & bit)){
+                word |= bit;
+                ++size_;
+            }
+            return Iterator(this, index);
+        }
+
+        Iterator findIndex(size_t index)const
+        {
+            if(exist(index))
+                return Iterator(this, index);
+            return end();
+        }
+
+        Iterator eraseIndex(size_t index)
+        {
+            if(!exist(index))
+                return end();
+            presence_[index / WORD_BITS] &= ~(1ull << (index % WORD_BITS));
+            --size_;
+            return next(index);
+        }
+
+        bool exist(size_t index)const noexcept
+        {
+            return 0 != (presence_[index / WORD_BITS] & (1ull << (index % WORD_BITS)));
+        }
+
+        size_t nextFrom(size_t index)const noexcept
+        {
+            if(index >= TOTAL_SIZE)
+                return INVALID_INDEX;
+            size_t wordIdx = index / WORD_BITS;
+            uint64_t word = presence_[wordIdx] & (~0ull << (index % WORD_BITS));
+            while(0 == word){
+                if(++wordIdx >= WORDS_COUNT)
+                    return INVALID_INDEX;
+                word = presence_[wordIdx];
+            }
+            return wordIdx*WORD_BITS + __builtin_ctzll(word);
+        }
+
+        Iterator next(IndexT index)const
+        {
+            return Iterator(this, nextFrom(index + 1));
+        }
+
+        ValueT &get(IndexT index)const
+        {
+            if(!exist(index))
+                throw std::runtime_error("FixedSuffixTree::get: element is not exist at index");
+            return values_[index];
+        }
+
+    private:
+        mutable std::array<ValueT, TOTAL_SIZE> values_;
+        std::array<uint64_t, WORDS_COUNT> presence_;
+        size_t size_;
+    };
+
+}
+
+/// DimsT is Dims<...> or Pow2Dims<...>
+template<typename DimsT, typename ContValueT>
+using FixedSuffixTree = st_suffix_tree_impl::FixedSuffixTree<DimsT, ContValueT>;
+
+}
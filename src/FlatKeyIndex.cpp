@@ -0,0 +1,98 @@
+#include "FlatKeyIndex.h"
+
+#include <algorithm>
+
+using namespace aux;
+
+namespace{
+    /// table is grown when it is filled more than MAX_LOAD_NUM/MAX_LOAD_DEN
+    const size_t MAX_LOAD_NUM = 7;
+    const size_t MAX_LOAD_DEN = 8;
+
+    size_t capacityFor(size_t count, size_t minCapacity)
+    {
+        size_t capacity = minCapacity;
+        while(capacity*MAX_LOAD_NUM < count*MAX_LOAD_DEN)
+            capacity *= 2;
+        return capacity;
+    }
+}
+
+FlatKeyIndex::FlatKeyIndex():
+    size_(0)
+{
+}
+
+size_t &FlatKeyIndex::operator[](
+        KeyViewT key)
+{
+    uint64_t hash = hashBytes(key.data(), key.length());
+    size_t pos = findSlot(key, hash);
+    if(NOT_FOUND != pos)
+        return slots_[pos].second;
+
+    if(slots_.size()*MAX_LOAD_NUM < (size_ + 1)*MAX_LOAD_DEN)
+        rehash(capacityFor(size_ + 1, std::max(MIN_CAPACITY, slots_.size()*2)));
+    pos = findEmpty(hash);
+    setControl(pos, static_cast<int8_t>(hash & 0x7f));
+    slots_[pos] = value_type(key, 0);
+    ++size_;
+    return slots_[pos].second;
+}
+
+void FlatKeyIndex::reserve(
+        size_t count)
+{
+    size_t capacity = capacityFor(count, MIN_CAPACITY);
+    if(capacity > slots_.size())
+        rehash(capacity);
+}
+
+void FlatKeyIndex::clear()noexcept
+{
+    ControlT tmpControl;
+    SlotsT tmpSlots;
+    std::swap(tmpControl, control_);
+    std::swap(tmpSlots, slots_);
+    size_ = 0;
+}
+
+size_t FlatKeyIndex::findEmpty(
+        uint64_t hash)const noexcept
+{
+    size_t mask = slots_.size() - 1;
+    size_t pos = (hash >> 7) & mask;
+    for(size_t step = GROUP_WIDTH;; step += GROUP_WIDTH){
+        uint32_t bits = matchGroup(control_.data() + pos, EMPTY_CONTROL);
+        if(0 != bits)
+            return (pos + __builtin_ctz(bits)) & mask;
+        pos = (pos + step) & mask;
+    }
+}
+
+void FlatKeyIndex::setControl(
+        size_t pos,
+        int8_t value)noexcept
+{
+    control_[pos] = value;
+    if(pos < GROUP_WIDTH - 1)
+        control_[slots_.size() + pos] = value;
+}
+
+void FlatKeyIndex::rehash(
+        size_t capacity)
+{
+    ControlT oldControl(capacity + GROUP_WIDTH - 1, EMPTY_CONTROL);
+    SlotsT oldSlots(capacity);
+    std::swap(oldControl, control_);
+    std::swap(oldSlots, slots_);
+    for(size_t i = 0; i < oldSlots.size(); ++i){
+        if(EMPTY_CONTROL == oldControl[i])
+            continue;
+        const value_type &val = oldSlots[i];
+        uint64_t hash = hashBytes(val.first.data(), val.first.length());
+        size_t pos = findEmpty(hash);
+        setControl(pos, oldControl[i]);
+        slots_[pos] = val;
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "HashUtils.h"
+
+namespace aux {
+
+    /// Open addressing map from subkey to its index (SwissTable layout):
+    /// array of control bytes (EMPTY_CONTROL or 7 low bits of the key hash) and array of slots
+    /// {string_view, index} stored inline. Lookup compares a group of 16 control bytes at once
+    /// and touches slots only for matched fingerprints. Entries are never erased.
+    class FlatKeyIndex{
+    public:
+        typedef std::string_view KeyViewT;
+        typedef std::pair<KeyViewT, size_t> value_type;
+
+    private:
+        typedef std::vector<value_type> SlotsT;
+        typedef std::vector<int8_t> ControlT;
+
+        static constexpr size_t GROUP_WIDTH = 16;
+        static constexpr size_t MIN_CAPACITY = 16;
+        static constexpr int8_t EMPTY_CONTROL = -128;
+        static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    public:
+        class const_iterator{
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef FlatKeyIndex::value_type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const value_type *pointer;
+            typedef const value_type &reference;
+
+            const_iterator(): cont_(nullptr), pos_(0){}
+
+            reference operator*()const noexcept{return cont_->slots_[pos_];}
+            pointer operator->()const noexcept{return &cont_->slots_[pos_];}
+
+            const_iterator &operator++()noexcept
+            {
+                pos_ = cont_->nextUsed(pos_ + 1);
+                return *this;
+            }
+
+            const_iterator operator++(int)noexcept
+            {
+                const_iterator res(*this);
+                ++(*this);
+                return res;
+            }
+
+            bool operator==(const const_iterator &rgt)const noexcept{return pos_ == rgt.pos_;}
+            bool operator!=(const const_iterator &rgt)const noexcept{return pos_ != rgt.pos_;}
+
+        private:
+            friend class FlatKeyIndex;
+            const_iterator(const FlatKeyIndex *cont, size_t pos): cont_(cont), pos_(pos){}
+
+        private:
+            const FlatKeyIndex *cont_;
+            size_t pos_;
+        };
+        typedef const_iterator iterator;
+
+        FlatKeyIndex();
+
+        size_t size()const noexcept{return size_;}
+
+        bool empty()const noexcept{return 0 == size_;}
+
+        const_iterator begin()const noexcept{return const_iterator(this, nextUsed(0));}
+
+        const_iterator end()const noexcept{return const_iterator(this, slots_.size());}
+
+        const_iterator find(
+                KeyViewT key)const noexcept
+        {
+            size_t pos = findSlot(key, hashBytes(key.data(), key.length()));
+            return const_iterator(this, (NOT_FOUND == pos)? slots_.size(): pos);
+        }
+
+        /// returns index of key, key is added with index 0 if it doesn't exist
+        size_t &operator[](
+                KeyViewT key);
+
+        void reserve(
+                size_t count);
+
+        void clear()noexcept;
+
+    private:
+        size_t findSlot(
+                KeyViewT key,
+                uint64_t hash)const noexcept
+        {
+            if(slots_.empty())
+                return NOT_FOUND;
+            size_t mask = slots_.size() - 1;
+            int8_t fingerprint = static_cast<int8_t>(hash & 0x7f);
+            size_t pos = (hash >> 7) & mask;
+            for(size_t step = GROUP_WIDTH;; step += GROUP_WIDTH){
+                const int8_t *group = control_.data() + pos;
+                for(uint32_t bits = matchGroup(group, fingerprint); 0 != bits; bits &= bits - 1){
+                    size_t slot = (pos + __builtin_ctz(bits)) & mask;
+                    const KeyViewT &slotKey = slots_[slot].first;
+                    if(slotKey.length() == key.length() && 0 == memcmp(slotKey.data(), key.data(), key.length()))
+                        return slot;
+                }
+                if(0 != matchGroup(group, EMPTY_CONTROL))
+                    return NOT_FOUND;
+                pos = (pos + step) & mask;
+            }
+        }
+
+        /// bit i of the result is set if group[i] == value
+        static uint32_t matchGroup(
+                const int8_t *group,
+                int8_t value)noexcept
+        {
+#if defined(__SSE2__)
+            __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#else
+            uint32_t res = 0;
+            for(size_t i = 0; i < GROUP_WIDTH; ++i)
+                res |= static_cast<uint32_t>(value == group[i]) << i;
+            return res;
+#endif
+        }
+
+        size_t nextUsed(
+                size_t pos)const noexcept
+        {
+            while(pos < slots_.size() && EMPTY_CONTROL == control_[pos])
+                ++pos;
+            return pos;
+        }
+
+        size_t findEmpty(
+                uint64_t hash)const noexcept;
+
+        void setControl(
+                size_t pos,
+                int8_t value)noexcept;
+
+        void rehash(
+                size_t capacity);
+
+    private:
+        /// capacity + GROUP_WIDTH - 1 bytes, the tail mirrors the head so a group never wraps
+        ControlT control_;
+        SlotsT slots_;
+        size_t size_;
+    };
+
+}
@@ -0,0 +1,437 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+
+#include "StaticSuffixTree.h"
+#include "PresenceBitmap.h"
+
+namespace st_suffix_tree{
+
+/// Dense container with growable dimensions: every level has capacity with headroom and strides
+/// are products of capacities, so a new subkey takes a reserved slot in O(1). When a level runs out
+/// of capacity, the grid with larger capacities is reserved and blocks of the old grid are migrated
+/// incrementally: every modification moves MIGRATE_BLOCKS_PER_OP blocks, key based modifications
+/// migrate the block of the key on demand and migrate() lets the owner push the re-layout from its
+/// idle loop. Values of the grid are allocated by blocks on the first write into the block and words
+/// of the presence bitmap are committed by pages, so re-layout doesn't fill the whole grid.
+/// Const methods don't migrate blocks: keys of not migrated blocks are read from the old grid, so
+/// concurrent readers are safe while no thread modifies the container.
+/// Builder has to append new subkeys (parseNewKey()), e.g. SuffixTreeTraits.
+/// Iterators are invalidated by insert(), which starts re-layout.
+template<typename ContBuilderT, typename ContValueT>
+class GrowableSuffixTree
+{
+public:
+    typedef ContBuilderT BuilderT;
+    typedef typename BuilderT::KeyViewT KeyViewT;
+    typedef typename BuilderT::ParsedKeyT ParsedKeyT;
+    typedef typename BuilderT::SuffixLevel SuffixLevel;
+    typedef ContValueT ValueT;
+    typedef GrowableSuffixTree<ContBuilderT, ContValueT> ThisTypeT;
+    typedef SuffixTreeIterator<ThisTypeT> Iterator;
+
+    static constexpr size_t LEVELS_COUNT = SuffixLevel::leaf_Suffix + 1;
+    /// slots of the old grid migrated at once
+    static constexpr size_t MIGRATE_BLOCK_SIZE = 4096;
+    static constexpr size_t MIGRATE_BLOCKS_PER_OP = 2;
+    /// default headroom of every level in percents of the count of subkeys
+    static constexpr size_t DEFAULT_HEADROOM = 50;
+
+    typedef std::array<size_t, LEVELS_COUNT> CapacitiesT;
+
+    friend Iterator;
+
+private:
+    typedef std::array<size_t, LEVELS_COUNT> SubkeysT;
+
+    struct GridT{
+        CapacitiesT capacities_;
+        /// strides_[lvl] is product of capacities of levels below lvl
+        CapacitiesT strides_;
+        /// values of blocks of MIGRATE_BLOCK_SIZE slots, block is allocated by the first write
+        std::vector<std::unique_ptr<ValueT[]>> blocks_;
+        /// words of optional_, pages are committed by the first write
+        st_suffix_tree_impl::ReservedMemory words_;
+        st_suffix_tree_impl::PresenceBitmap optional_;
+
+        /// reserves the grid, values and words aren't touched
+        void assign(const CapacitiesT &capacities)
+        {
+            capacities_ = capacities;
+            size_t totalSize = 1;
+            for(size_t lvl = LEVELS_COUNT; lvl-- > 0;){
+                strides_[lvl] = totalSize;
+                totalSize *= capacities_[lvl];
+            }
+            blocks_.clear();
+            blocks_.resize((totalSize + MIGRATE_BLOCK_SIZE - 1) / MIGRATE_BLOCK_SIZE);
+            words_.reserve(st_suffix_tree_impl::PresenceBitmap::wordsCount(totalSize)*sizeof(uint64_t));
+            optional_.attachZeros(reinterpret_cast<uint64_t *>(words_.data()), totalSize);
+        }
+
+        void swap(GridT &grid)noexcept
+        {
+            std::swap(capacities_, grid.capacities_);
+            std::swap(strides_, grid.strides_);
+            std::swap(blocks_, grid.blocks_);
+            std::swap(words_, grid.words_);
+            optional_.swap(grid.optional_);
+        }
+
+        void release()
+        {
+            optional_ = st_suffix_tree_impl::PresenceBitmap();
+            words_ = st_suffix_tree_impl::ReservedMemory();
+            std::vector<std::unique_ptr<ValueT[]>>().swap(blocks_);
+        }
+
+        /// resets all bits and frees blocks of values
+        void clear()
+        {
+            optional_.clear();
+            for(auto &block: blocks_)
+                block.reset();
+        }
+
+        /// value of the slot of the allocated block
+        ValueT &value(size_t index)const noexcept
+        {
+            return blocks_[index / MIGRATE_BLOCK_SIZE][index % MIGRATE_BLOCK_SIZE];
+        }
+
+        /// value of the slot for write, block of the slot is allocated and filled by default values
+        ValueT &slot(size_t index)
+        {
+            std::unique_ptr<ValueT[]> &block = blocks_[index / MIGRATE_BLOCK_SIZE];
+            if(nullptr == block){
+                size_t first = index / MIGRATE_BLOCK_SIZE * MIGRATE_BLOCK_SIZE;
+                size_t size = std::min(MIGRATE_BLOCK_SIZE, optional_.size() - first);
+                block.reset(new ValueT[size]);
+                std::fill(block.get(), block.get() + size, BuilderT::defaultValue());
+            }
+            return block[index % MIGRATE_BLOCK_SIZE];
+        }
+
+        template<typename KeyT>
+        size_t index(const KeyT &key)const noexcept
+        {
+            size_t index = 0;
+            for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl)
+                index += key[lvl]*strides_[lvl];
+            return index;
+        }
+
+        void subkeys(
+                size_t index,
+                SubkeysT &key)const noexcept
+        {
+            for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl)
+                key[lvl] = index / strides_[lvl] % capacities_[lvl];
+        }
+
+        template<typename KeyT>
+        bool contains(const KeyT &key)const noexcept
+        {
+            for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl){
+                if(key[lvl] >= capacities_[lvl])
+                    return false;
+            }
+            return true;
+        }
+
+        /// index of the first slot with key greater than key (not less if orEqual), keys are ordered
+        /// by subkeys, so the order of slots is the same in grids of any capacities
+        template<typename KeyT>
+        size_t bound(
+                const KeyT &key,
+                bool orEqual)const noexcept
+        {
+            size_t res = 0;
+            for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl){
+                if(key[lvl] >= capacities_[lvl])
+                    return 0 == lvl? optional_.size(): res + strides_[lvl - 1];
+                res += key[lvl]*strides_[lvl];
+            }
+            return orEqual? res: res + 1;
+        }
+
+        /// first set bit at from or after it or NPOS
+        size_t first(size_t from)const noexcept
+        {
+            if(from >= optional_.size())
+                return st_suffix_tree_impl::PresenceBitmap::NPOS;
+            return optional_.test(from)? from: optional_.next(from);
+        }
+    };
+
+public:
+    /// capacity of every level is at least the count of subkeys plus headroom percents
+    explicit GrowableSuffixTree(
+            const BuilderT &builder,
+            size_t headroom = DEFAULT_HEADROOM):
+        builder_(builder), size_(0), migrateNext_(0), blocksLeft_(0)
+    {
+        CapacitiesT capacities;
+        for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl){
+            size_t count = builder_.suffixCount(static_cast<SuffixLevel>(lvl));
+            capacities[lvl] = std::max<size_t>(count + count*headroom/100, 1);
+        }
+        grid_.assign(capacities);
+    }
+
+    GrowableSuffixTree(const GrowableSuffixTree &) = delete;
+    GrowableSuffixTree &operator=(const GrowableSuffixTree &) = delete;
+
+    Iterator begin()const
+    {
+        return Iterator(this, firstFrom(0));
+    }
+
+    Iterator end()const
+    {
+        return Iterator();
+    }
+
+    /// unknown subkeys are added to the builder, level without free capacity starts re-layout
+    Iterator insert(
+            KeyViewT key,
+            const ValueT &val)
+    {
+        ParsedKeyT parsedKey;
+        if(!builder_.parseNewKey(key, parsedKey))
+            return end();
+        if(!grid_.contains(parsedKey))
+            grow(parsedKey);
+        migrate(MIGRATE_BLOCKS_PER_OP);
+        size_t index = locate(parsedKey);
+        grid_.slot(index) = val;
+        if(grid_.optional_.set(index))
+            ++size_;
+        return Iterator(this, index);
+    }
+
+    Iterator insert(
+            const char *key,
+            size_t length,
+            const ValueT &val)
+    {
+        return insert(KeyViewT(key, length), val);
+    }
+
+    Iterator find(KeyViewT key)const
+    {
+        ParsedKeyT parsedKey;
+        if(!builder_.parseKey(key, parsedKey))
+            return end();
+        size_t index = grid_.index(parsedKey);
+        if(!grid_.optional_.test(index) && !inOldGrid(parsedKey))
+            return end();
+        return Iterator(this, index);
+    }
+
+    Iterator find(
+            const char *key,
+            size_t length)const
+    {
+        return find(KeyViewT(key, length));
+    }
+
+    Iterator erase(KeyViewT key)
+    {
+        ParsedKeyT parsedKey;
+        if(!builder_.parseKey(key, parsedKey))
+            return end();
+        migrate(MIGRATE_BLOCKS_PER_OP);
+        size_t index = locate(parsedKey);
+        if(!grid_.optional_.reset(index))
+            return end();
+        --size_;
+        return next(index);
+    }
+
+    Iterator erase(
+            const char *key,
+            size_t length)
+    {
+        return erase(KeyViewT(key, length));
+    }
+
+    Iterator erase(const Iterator &it)
+    {
+        if(end() == it)
+            return end();
+        SubkeysT key;
+        grid_.subkeys(it.index(), key);
+        size_t index = locate(key);
+        if(!grid_.optional_.reset(index))
+            return end();
+        --size_;
+        return next(index);
+    }
+
+    size_t size()const noexcept{return size_;}
+
+    /// count of values with keys in [first, last], keys are ordered by indexes of subkeys
+    size_t count(
+            const ParsedKeyT &first,
+            const ParsedKeyT &last)const
+    {
+        if(!builder_.isValid(first) || !builder_.isValid(last))
+            return 0;
+        size_t res = grid_.optional_.countRange(grid_.index(first), grid_.index(last) + 1);
+        if(migrating())
+            res += old_.optional_.countRange(old_.bound(first, true), old_.bound(last, false));
+        return res;
+    }
+
+    const BuilderT &builder()const noexcept{return builder_;}
+
+    size_t capacity(SuffixLevel level)const noexcept{return grid_.capacities_[level];}
+
+    /// reserves capacities of levels, larger capacity of any level starts re-layout
+    void reserve(const CapacitiesT &capacities)
+    {
+        CapacitiesT target = grid_.capacities_;
+        bool larger = false;
+        for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl){
+            larger = larger || capacities[lvl] > target[lvl];
+            target[lvl] = std::max(target[lvl], capacities[lvl]);
+        }
+        if(larger)
+            relayout(target);
+    }
+
+    /// true while blocks of the old grid are not migrated
+    bool migrating()const noexcept{return 0 != blocksLeft_;}
+
+    /// migrates up to blocks blocks of the old grid, returns true if migration is finished
+    bool migrate(size_t blocks)
+    {
+        for(; 0 != blocksLeft_ && 0 != blocks; --blocks){
+            while(migrated_.test(migrateNext_))
+                ++migrateNext_;
+            migrateBlock(migrateNext_);
+        }
+        return 0 == blocksLeft_;
+    }
+
+    void clear()
+    {
+        size_ = 0;
+        old_.release();
+        blocksLeft_ = 0;
+        grid_.clear();
+    }
+
+private:
+    /// grows levels, which can't place subkeys of key
+    void grow(const ParsedKeyT &key)
+    {
+        CapacitiesT capacities = grid_.capacities_;
+        for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl){
+            if(key[lvl] >= capacities[lvl])
+                capacities[lvl] = std::max(key[lvl] + 1, capacities[lvl]*2);
+        }
+        relayout(capacities);
+    }
+
+    /// reserves the grid with capacities, old grid is migrated incrementally
+    void relayout(const CapacitiesT &capacities)
+    {
+        migrate(blocksLeft_);
+        old_.swap(grid_);
+        grid_.assign(capacities);
+        size_t slots = old_.optional_.size();
+        blocksLeft_ = (slots + MIGRATE_BLOCK_SIZE - 1) / MIGRATE_BLOCK_SIZE;
+        migrated_.assign(blocksLeft_);
+        migrateNext_ = 0;
+        if(0 == blocksLeft_)
+            old_.release();
+    }
+
+    /// index of key in the current grid, block of the old grid with key is migrated before
+    template<typename KeyT>
+    size_t locate(const KeyT &key)
+    {
+        if(migrating() && old_.contains(key)){
+            size_t block = old_.index(key) / MIGRATE_BLOCK_SIZE;
+            if(!migrated_.test(block))
+                migrateBlock(block);
+        }
+        return grid_.index(key);
+    }
+
+    /// moves values of the block to the current grid, their bits of the old grid are reset,
+    /// so bits of the old grid are values, which aren't migrated yet
+    void migrateBlock(size_t block)
+    {
+        size_t first = block*MIGRATE_BLOCK_SIZE;
+        size_t last = std::min(first + MIGRATE_BLOCK_SIZE, old_.optional_.size());
+        SubkeysT key;
+        for(size_t index = old_.first(first); index < last; index = old_.optional_.next(index)){
+            old_.subkeys(index, key);
+            size_t newIndex = grid_.index(key);
+            grid_.slot(newIndex) = std::move(old_.value(index));
+            grid_.optional_.set(newIndex);
+            old_.optional_.reset(index);
+        }
+        migrated_.set(block);
+        if(0 == --blocksLeft_)
+            old_.release();
+    }
+
+    template<typename KeyT>
+    bool inOldGrid(const KeyT &key)const noexcept
+    {
+        return migrating() && old_.contains(key) && old_.optional_.test(old_.index(key));
+    }
+
+    /// first present slot of the current grid at from or after it, values of the old grid
+    /// are placed by their slots in the current grid
+    st_suffix_tree_impl::IndexT firstFrom(size_t from)const noexcept
+    {
+        size_t res = grid_.first(from);
+        if(migrating() && from < grid_.optional_.size()){
+            SubkeysT key;
+            grid_.subkeys(from, key);
+            size_t oldIndex = old_.first(old_.bound(key, true));
+            if(st_suffix_tree_impl::PresenceBitmap::NPOS != oldIndex){
+                old_.subkeys(oldIndex, key);
+                res = std::min(res, grid_.index(key));
+            }
+        }
+        return res;
+    }
+
+    Iterator next(st_suffix_tree_impl::IndexT index)const
+    {
+        return Iterator(this, firstFrom(index + 1));
+    }
+
+    ValueT &get(st_suffix_tree_impl::IndexT index)const
+    {
+        if(grid_.optional_.test(index))
+            return grid_.value(index);
+        SubkeysT key;
+        grid_.subkeys(index, key);
+        if(!inOldGrid(key))
+            throw std::runtime_error("GrowableSuffixTree::get: element is not exist at index");
+        return old_.value(old_.index(key));
+    }
+
+private:
+    BuilderT builder_;
+    size_t size_;
+    GridT grid_;
+    /// grid with previous capacities, released when all blocks are migrated
+    GridT old_;
+    st_suffix_tree_impl::PresenceBitmap migrated_;
+    size_t migrateNext_;
+    size_t blocksLeft_;
+};
+
+}
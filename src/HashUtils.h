@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace aux {
+
+    const uint64_t HASH_PRIME_0 = 0xa0761d6478bd642full;
+    const uint64_t HASH_PRIME_1 = 0xe7037ed1a0b428dbull;
+
+    /// 64x64->128 multiplication folded to 64 bits
+    inline uint64_t hashMix(
+            uint64_t a,
+            uint64_t b)noexcept
+    {
+        __uint128_t res = static_cast<__uint128_t>(a) * b;
+        return static_cast<uint64_t>(res) ^ static_cast<uint64_t>(res >> 64);
+    }
+
+    /// fast non-cryptographic hash of byte string, reads 8 bytes per step
+    inline uint64_t hashBytes(
+            const char *data,
+            size_t length,
+            uint64_t seed = 0)noexcept
+    {
+        uint64_t hash = seed ^ HASH_PRIME_0 ^ length;
+        for(; length >= 8; length -= 8, data += 8){
+            uint64_t word;
+            memcpy(&word, data, 8);
+            hash = hashMix(hash ^ word, HASH_PRIME_1);
+        }
+        uint64_t tail = 0;
+        memcpy(&tail, data, length);
+        return hashMix(hash ^ tail ^ HASH_PRIME_1, HASH_PRIME_0);
+    }
+
+    /// maps hash to [0, range) without division
+    inline size_t hashRange(
+            uint64_t hash,
+            size_t range)noexcept
+    {
+        return static_cast<size_t>((static_cast<__uint128_t>(hash) * range) >> 64);
+    }
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+
+#include "SuffixTreeTraits.h"
+#include "SuffixTree.h"
+
+namespace aux{
+
+    /// Traits of the hybrid container: upper levels are pointer nodes of SuffixTree,
+    /// the last two key levels are folded into one dense leaf level, so every leaf node
+    /// is a contiguous block of values with presence bitmap for all pairs of last subkeys.
+    /// Dictionaries of the two dense levels are fixed at construction, keys with new subkeys
+    /// at these levels are rejected; upper level dictionaries grow as in SuffixTreeTraits.
+    template <size_t LevelsT, typename ContKeyT, typename ContValueT>
+    class HybridTraits {
+    public:
+        typedef SuffixTreeTraits<LevelsT, ContKeyT, ContValueT> KeyTraitsT;
+        typedef ContKeyT KeyT;
+        typedef typename KeyTraitsT::KeyViewT KeyViewT;
+        typedef ContValueT ValueT;
+        typedef HybridTraits<LevelsT, ContKeyT, ContValueT> ThisTypeT;
+    public:
+        static constexpr size_t NUMBER_LEVELS = LevelsT - 1;
+        typedef typename SuffixLevelEnum<NUMBER_LEVELS>::Levels SuffixLevel;
+        typedef std::array<size_t, SuffixLevel::total_Suffix> ParsedKeyT;
+        typedef typename KeyTraitsT::ParsedKeyT FullParsedKeyT;
+
+        static_assert(3 <= LevelsT, "HybridTraits: at least 3 key levels are expected");
+
+        template<SuffixLevel LevelIdxT, class DummyT = void>
+        struct NodeTraits {
+            typedef std::string KeyTypeT;
+            typedef suffix_tree::suffix_tree_impl::SuffixNode<HybridTraits, LevelIdxT> NodeTypeT;
+        };
+
+        template<class DummyT>
+        struct NodeTraits<ThisTypeT::SuffixLevel::root_Suffix, DummyT> {
+            typedef std::string KeyTypeT;
+            typedef suffix_tree::suffix_tree_impl::RootNode<HybridTraits> NodeTypeT;
+        };
+
+        template<class DummyT>
+        struct NodeTraits<ThisTypeT::SuffixLevel::leaf_Suffix, DummyT> {
+            typedef std::string KeyTypeT;
+            typedef suffix_tree::suffix_tree_impl::LeafNode<HybridTraits, ValueT> NodeTypeT;
+
+            static ValueT defaultValue() { return ValueT(); }
+        };
+
+        template<class DummyT>
+        struct NodeTraits<ThisTypeT::SuffixLevel::total_Suffix, DummyT> {
+            typedef std::string KeyTypeT;
+            typedef void NodeTypeT;
+        };
+
+        explicit HybridTraits(
+                const KeyTraitsT &keys):
+            keys_(keys),
+            outerCount_(keys.suffixCount(static_cast<typename KeyTraitsT::SuffixLevel>(DENSE_OUTER))),
+            innerCount_(keys.suffixCount(static_cast<typename KeyTraitsT::SuffixLevel>(DENSE_INNER)))
+        {}
+
+        size_t levels() const noexcept
+        {
+            return SuffixLevel::total_Suffix;
+        }
+
+        bool parseKey(
+                KeyViewT key,
+                ParsedKeyT &res) const
+        {
+            FullParsedKeyT fullKey;
+            if(!keys_.parseKey(key, fullKey))
+                return false;
+            return fold(fullKey, res);
+        }
+
+        bool parseKey(
+                const char *key,
+                size_t length,
+                ParsedKeyT &res) const
+        {
+            return parseKey(KeyViewT(key, length), res);
+        }
+
+        /// returns indexes of subkeys, all indexes are INVALID_INDEX if key is unknown
+        ParsedKeyT parseKey(
+                KeyViewT key) const
+        {
+            ParsedKeyT res;
+            if(!parseKey(key, res))
+                res.fill(suffix_tree::suffix_tree_impl::INVALID_INDEX);
+            return res;
+        }
+
+        bool isValid(
+                const ParsedKeyT &key) const noexcept
+        {
+            for(size_t i = 0; i < key.size(); ++i){
+                if(key[i] >= suffixCount(static_cast<SuffixLevel>(i)))
+                    return false;
+            }
+            return true;
+        }
+
+        bool parseNewKey(
+                const char *key,
+                size_t length,
+                ParsedKeyT &res)
+        {
+            return parseNewKey(KeyViewT(key, length), res);
+        }
+
+        /// subkeys of dense levels are checked before unknown subkeys are added to upper levels,
+        /// so rejected keys don't grow dictionaries
+        bool parseNewKey(
+                KeyViewT key,
+                ParsedKeyT &res)
+        {
+            size_t tokenLastPosition[LevelsT];
+            if(DENSE_INNER != findDelimiters(key.data(), key.length(), keys_.delimeter(), tokenLastPosition, DENSE_INNER))
+                return false;
+            tokenLastPosition[DENSE_INNER] = key.length();
+            KeyViewT subkeys[LevelsT];
+            for(size_t i = 0, startIdx = 0; i < LevelsT; startIdx = tokenLastPosition[i++] + 1)
+                subkeys[i] = KeyViewT(key.data() + startIdx, tokenLastPosition[i] - startIdx);
+
+            FullParsedKeyT fullKey;
+            if(!keys_.getKeyIndex(DENSE_OUTER, subkeys[DENSE_OUTER], fullKey[DENSE_OUTER])
+                    || !keys_.getKeyIndex(DENSE_INNER, subkeys[DENSE_INNER], fullKey[DENSE_INNER]))
+                return false;
+            for(size_t i = 0; i < DENSE_OUTER; ++i)
+                fullKey[i] = keys_.addSubkey(i, subkeys[i]);
+            return fold(fullKey, res);
+        }
+
+        KeyT assembleKey(
+                const ParsedKeyT &key) const
+        {
+            FullParsedKeyT fullKey;
+            for(size_t i = 0; i < SuffixLevel::leaf_Suffix; ++i)
+                fullKey[i] = key[i];
+            fullKey[DENSE_OUTER] = key[SuffixLevel::leaf_Suffix] / innerCount_;
+            fullKey[DENSE_INNER] = key[SuffixLevel::leaf_Suffix] % innerCount_;
+            return keys_.assembleKey(fullKey);
+        }
+
+        size_t suffixCount(
+                SuffixLevel level) const noexcept
+        {
+            if(SuffixLevel::leaf_Suffix == level)
+                return outerCount_*innerCount_;
+            return keys_.suffixCount(static_cast<typename KeyTraitsT::SuffixLevel>(level));
+        }
+
+        static ValueT defaultValue(){return ValueT();}
+
+        bool freeze()
+        {
+            return keys_.freeze();
+        }
+
+        /// traits, which resolve subkeys of all key levels
+        const KeyTraitsT &keyTraits() const noexcept{return keys_;}
+
+    private:
+        static constexpr size_t DENSE_OUTER = LevelsT - 2;
+        static constexpr size_t DENSE_INNER = LevelsT - 1;
+
+        bool fold(
+                const FullParsedKeyT &fullKey,
+                ParsedKeyT &res) const noexcept
+        {
+            if(fullKey[DENSE_OUTER] >= outerCount_ || fullKey[DENSE_INNER] >= innerCount_)
+                return false;
+            for(size_t i = 0; i < SuffixLevel::leaf_Suffix; ++i)
+                res[i] = fullKey[i];
+            res[SuffixLevel::leaf_Suffix] = fullKey[DENSE_OUTER]*innerCount_ + fullKey[DENSE_INNER];
+            return true;
+        }
+
+    private:
+        KeyTraitsT keys_;
+        size_t outerCount_;
+        size_t innerCount_;
+    };
+
+}
+
+namespace suffix_tree{
+
+    /// SuffixTree with pointer nodes for upper levels and dense blocks for the last two levels
+    template <size_t LevelsT, typename KeyT, typename ValueT>
+    using HybridSuffixTree = SuffixTree<aux::HybridTraits<LevelsT, KeyT, ValueT>>;
+
+}
@@ -0,0 +1,141 @@
+#include "KeyTokenizer.h"
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KEY_TOKENIZER_X86_
+#endif
+
+using namespace aux;
+
+namespace{
+    typedef size_t (*FindDelimitersFuncT)(const char *, size_t, char, size_t *, size_t);
+
+    /// stores positions of set bits of mask, returns false if more than maxCount delimiters are found
+    inline bool storePositions(
+            uint64_t mask,
+            size_t base,
+            size_t *positions,
+            size_t &count,
+            size_t maxCount)
+    {
+        while(0 != mask){
+            if(maxCount == count){
+                ++count;
+                return false;
+            }
+            positions[count++] = base + __builtin_ctzll(mask);
+            mask &= mask - 1;
+        }
+        return true;
+    }
+
+    inline bool scalarTail(
+            const char *key,
+            size_t start,
+            size_t length,
+            char delimiter,
+            size_t *positions,
+            size_t &count,
+            size_t maxCount)
+    {
+        for(size_t i = start; i < length; ++i){
+            if(delimiter == key[i]){
+                if(maxCount == count){
+                    ++count;
+                    return false;
+                }
+                positions[count++] = i;
+            }
+        }
+        return true;
+    }
+
+#ifdef KEY_TOKENIZER_X86_
+    __attribute__((target("sse2")))
+    size_t findDelimitersSse2(
+            const char *key,
+            size_t length,
+            char delimiter,
+            size_t *positions,
+            size_t maxCount)
+    {
+        const __m128i pattern = _mm_set1_epi8(delimiter);
+        size_t count = 0;
+        size_t i = 0;
+        for(; i + 16 <= length; i += 16){
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key + i));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern)));
+            if(!storePositions(mask, i, positions, count, maxCount))
+                return count;
+        }
+        scalarTail(key, i, length, delimiter, positions, count, maxCount);
+        return count;
+    }
+
+    __attribute__((target("avx2")))
+    size_t findDelimitersAvx2(
+            const char *key,
+            size_t length,
+            char delimiter,
+            size_t *positions,
+            size_t maxCount)
+    {
+        const __m256i pattern = _mm256_set1_epi8(delimiter);
+        size_t count = 0;
+        size_t i = 0;
+        for(; i + 32 <= length; i += 32){
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(key + i));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern)));
+            if(!storePositions(mask, i, positions, count, maxCount))
+                return count;
+        }
+        if(i + 16 <= length){
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key + i));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(pattern))));
+            if(!storePositions(mask, i, positions, count, maxCount))
+                return count;
+            i += 16;
+        }
+        scalarTail(key, i, length, delimiter, positions, count, maxCount);
+        return count;
+    }
+#endif
+
+    FindDelimitersFuncT selectFindDelimiters()
+    {
+#ifdef KEY_TOKENIZER_X86_
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2"))
+            return findDelimitersAvx2;
+        if(__builtin_cpu_supports("sse2"))
+            return findDelimitersSse2;
+#endif
+        return findDelimitersScalar;
+    }
+
+}
+
+size_t aux::findDelimitersScalar(
+        const char *key,
+        size_t length,
+        char delimiter,
+        size_t *positions,
+        size_t maxCount)
+{
+    size_t count = 0;
+    scalarTail(key, 0, length, delimiter, positions, count, maxCount);
+    return count;
+}
+
+size_t aux::findDelimiters(
+        const char *key,
+        size_t length,
+        char delimiter,
+        size_t *positions,
+        size_t maxCount)
+{
+    static const FindDelimitersFuncT impl = selectFindDelimiters();
+    return impl(key, length, delimiter, positions, maxCount);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+namespace aux {
+
+    /// Finds positions of delimiter in key in a single pass over the key.
+    /// Positions of the first maxCount delimiters are stored into positions, return value is
+    /// the count of delimiters, but not more than maxCount + 1 (scan is stopped at that point).
+    /// Implementation is selected once by CPU features: AVX2, SSE2 or scalar loop.
+    size_t findDelimiters(
+            const char *key,
+            size_t length,
+            char delimiter,
+            size_t *positions,
+            size_t maxCount);
+
+    /// scalar implementation of findDelimiters, reference for vectorized ones
+    size_t findDelimitersScalar(
+            const char *key,
+            size_t length,
+            char delimiter,
+            size_t *positions,
+            size_t maxCount);
+
+}
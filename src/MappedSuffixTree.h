@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "TreeSnapshot.h"
+#include "KeyTokenizer.h"
+
+namespace suffix_tree{
+
+    /// Read only SuffixTree served directly from the mapped image written by SuffixTree::save().
+    /// Construction maps the file and checks the header, lookups walk offsets of the image
+    /// and don't allocate memory.
+    template<size_t LevelsT, typename ContValueT>
+    class MappedSuffixTree
+    {
+    public:
+        typedef ContValueT ValueT;
+        typedef std::string_view KeyViewT;
+        typedef std::array<size_t, LevelsT> ParsedKeyT;
+
+        static_assert(std::is_trivially_copyable<ValueT>::value && alignof(ValueT) <= 8,
+                      "MappedSuffixTree: value has to be trivially copyable");
+
+    public:
+        explicit MappedSuffixTree(const std::string &path):
+            file_(path),
+            header_(aux::checkSnapshotHeader(file_, aux::tree_SnapshotKind, LevelsT, sizeof(ValueT))),
+            dictionaries_(aux::readSnapshotDictionaries(file_, header_))
+        {}
+
+        MappedSuffixTree(const MappedSuffixTree &) = delete;
+        MappedSuffixTree &operator=(const MappedSuffixTree &) = delete;
+
+        bool parseKey(
+                KeyViewT key,
+                ParsedKeyT &res)const noexcept
+        {
+            size_t tokenLastPosition[LevelsT];
+            if(LevelsT - 1 != aux::findDelimiters(key.data(), key.length(), header_.delimeter_, tokenLastPosition, LevelsT - 1))
+                return false;
+            tokenLastPosition[LevelsT - 1] = key.length();
+            size_t startIdx = 0;
+            for(size_t i = 0; i < LevelsT; ++i){
+                if(!dictionaries_[i].find(KeyViewT(key.data() + startIdx, tokenLastPosition[i] - startIdx), res[i]))
+                    return false;
+                startIdx = tokenLastPosition[i] + 1; ///skip delimeter
+            }
+            return true;
+        }
+
+        bool find(
+                KeyViewT key,
+                ValueT &val)const noexcept
+        {
+            ParsedKeyT parsedKey;
+            if(!parseKey(key, parsedKey))
+                return false;
+            return find(parsedKey, val);
+        }
+
+        bool find(
+                const ParsedKeyT &parsedKey,
+                ValueT &val)const noexcept
+        {
+            uint64_t offset = header_.data_;
+            for(size_t level = 0; level + 1 < LevelsT; ++level){
+                const uint64_t *count = file_.template at<uint64_t>(offset);
+                const aux::SnapshotChild *children = (nullptr != count)?
+                        file_.template at<aux::SnapshotChild>(offset + sizeof(uint64_t), *count): nullptr;
+                if(nullptr == children)
+                    return false;
+                const aux::SnapshotChild *it = std::lower_bound(
+                        children, children + *count, parsedKey[level],
+                        [](const aux::SnapshotChild &child, size_t index){return child.index_ < index;});
+                if(children + *count == it || parsedKey[level] != it->index_)
+                    return false;
+                offset = it->offset_;
+            }
+
+            size_t count = 0;
+            const uint64_t *indexes = leafIndexes(offset, count);
+            const ValueT *values = leafValues(offset, count);
+            if(nullptr == indexes || nullptr == values)
+                return false;
+            const uint64_t *it = std::lower_bound(indexes, indexes + count, parsedKey[LevelsT - 1]);
+            if(indexes + count == it || parsedKey[LevelsT - 1] != *it)
+                return false;
+            val = values[it - indexes];
+            return true;
+        }
+
+        /// calls func(parsedKey, value) for every value in order of indexes of subkeys
+        template<typename FuncT>
+        void forEach(FuncT func)const
+        {
+            ParsedKeyT parsedKey;
+            forEach(header_.data_, 0, parsedKey, func);
+        }
+
+        size_t size()const noexcept{return header_.size_;}
+
+        const aux::SnapshotDictionary &dictionary(size_t level)const noexcept{return dictionaries_[level];}
+
+        std::string assembleKey(const ParsedKeyT &parsedKey)const
+        {
+            std::string res;
+            for(size_t i = 0; i < LevelsT; ++i){
+                if(0 != i)
+                    res += header_.delimeter_;
+                res += dictionaries_[i].key(parsedKey[i]);
+            }
+            return res;
+        }
+
+    private:
+        const uint64_t *leafIndexes(
+                uint64_t offset,
+                size_t &count)const noexcept
+        {
+            const uint64_t *cnt = file_.template at<uint64_t>(offset);
+            if(nullptr == cnt)
+                return nullptr;
+            count = *cnt;
+            return file_.template at<uint64_t>(offset + sizeof(uint64_t), count);
+        }
+
+        const ValueT *leafValues(
+                uint64_t offset,
+                size_t count)const noexcept
+        {
+            return file_.template at<ValueT>((offset + (count + 1)*sizeof(uint64_t) + 7) & ~uint64_t(7), count);
+        }
+
+        template<typename FuncT>
+        void forEach(
+                uint64_t offset,
+                size_t level,
+                ParsedKeyT &parsedKey,
+                FuncT &func)const
+        {
+            if(LevelsT - 1 == level){
+                size_t count = 0;
+                const uint64_t *indexes = leafIndexes(offset, count);
+                const ValueT *values = (nullptr != indexes)? leafValues(offset, count): nullptr;
+                if(nullptr == values)
+                    throw std::runtime_error("MappedSuffixTree::forEach: snapshot is corrupted");
+                for(size_t i = 0; i < count; ++i){
+                    parsedKey[level] = indexes[i];
+                    func(static_cast<const ParsedKeyT &>(parsedKey), values[i]);
+                }
+                return;
+            }
+            const uint64_t *count = file_.template at<uint64_t>(offset);
+            const aux::SnapshotChild *children = (nullptr != count)?
+                    file_.template at<aux::SnapshotChild>(offset + sizeof(uint64_t), *count): nullptr;
+            if(nullptr == children)
+                throw std::runtime_error("MappedSuffixTree::forEach: snapshot is corrupted");
+            for(size_t i = 0; i < *count; ++i){
+                if(children[i].offset_ >= offset)
+                    throw std::runtime_error("MappedSuffixTree::forEach: snapshot is corrupted");
+                parsedKey[level] = children[i].index_;
+                forEach(children[i].offset_, level + 1, parsedKey, func);
+            }
+        }
+
+    private:
+        aux::MappedFile file_;
+        const aux::SnapshotHeader &header_;
+        std::vector<aux::SnapshotDictionary> dictionaries_;
+    };
+
+}
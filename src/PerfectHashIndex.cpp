@@ -0,0 +1,87 @@
+#include "PerfectHashIndex.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace aux;
+
+PerfectHashIndex::PerfectHashIndex():
+    built_(false)
+{
+}
+
+bool PerfectHashIndex::build(const SourceT &keys)
+{
+    typedef std::pair<uint64_t, const SourceT::value_type *> HashedKeyT;
+    typedef std::vector<HashedKeyT> BucketT;
+
+    clear();
+    size_t count = keys.size();
+    if(0 == count){
+        built_ = true;
+        return true;
+    }
+
+    std::vector<uint64_t> hashes;
+    hashes.reserve(count);
+    std::vector<BucketT> buckets(std::max<size_t>(1, count / BUCKET_LOAD));
+    for(auto &key: keys){
+        uint64_t hash = hashBytes(key.first.data(), key.first.length());
+        hashes.push_back(hash);
+        buckets[hashRange(hash, buckets.size())].emplace_back(hash, &key);
+    }
+    /// keys with equal full hashes can't be separated by any seed
+    std::sort(std::begin(hashes), std::end(hashes));
+    if(std::end(hashes) != std::adjacent_find(std::begin(hashes), std::end(hashes)))
+        return false;
+
+    std::vector<size_t> order(buckets.size());
+    for(size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(
+            std::begin(order), std::end(order),
+            [&](size_t lft, size_t rgt){return buckets[lft].size() > buckets[rgt].size();});
+
+    entries_.resize(count);
+    seeds_.assign(buckets.size(), 0);
+    std::vector<bool> taken(count, false);
+    std::vector<size_t> slots;
+    for(size_t bucketIdx: order){
+        const BucketT &bucket = buckets[bucketIdx];
+        if(bucket.empty())
+            break;
+        uint32_t seed = 0;
+        for(; seed < MAX_SEED; ++seed){
+            slots.clear();
+            for(auto &key: bucket){
+                size_t pos = slot(key.first, seed);
+                if(taken[pos] || std::end(slots) != std::find(std::begin(slots), std::end(slots), pos))
+                    break;
+                slots.push_back(pos);
+            }
+            if(slots.size() == bucket.size())
+                break;
+        }
+        if(MAX_SEED == seed){
+            clear();
+            return false;
+        }
+        seeds_[bucketIdx] = seed;
+        for(size_t i = 0; i < bucket.size(); ++i){
+            const SourceT::value_type &key = *bucket[i].second;
+            taken[slots[i]] = true;
+            entries_[slots[i]] = EntryT{key.first.data(), key.first.length(), key.second};
+        }
+    }
+    built_ = true;
+    return true;
+}
+
+void PerfectHashIndex::clear()noexcept
+{
+    EntriesT tmpEntries;
+    SeedsT tmpSeeds;
+    std::swap(tmpEntries, entries_);
+    std::swap(tmpSeeds, seeds_);
+    built_ = false;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include "HashUtils.h"
+#include "FlatKeyIndex.h"
+
+namespace aux {
+
+    /// Minimal perfect hash over a fixed set of strings (hash and displace):
+    /// key hash selects a bucket, seed of the bucket selects the slot in the table of n entries.
+    /// Strings are not copied, entries refer to the storage of the source map,
+    /// lookup is two hash mixes and one memcmp.
+    class PerfectHashIndex{
+        struct EntryT{
+            const char *data_;
+            size_t length_;
+            size_t index_;
+        };
+        typedef std::vector<EntryT> EntriesT;
+        typedef std::vector<uint32_t> SeedsT;
+
+        /// average count of keys in a bucket
+        static constexpr size_t BUCKET_LOAD = 3;
+        static constexpr uint32_t MAX_SEED = 1u << 20;
+
+    public:
+        typedef std::string_view KeyViewT;
+        typedef FlatKeyIndex SourceT;
+
+        PerfectHashIndex();
+
+        /// builds index over keys, returns false if hash can't be built (index stays empty)
+        bool build(const SourceT &keys);
+
+        void clear()noexcept;
+
+        bool built()const noexcept{return built_;}
+
+        size_t size()const noexcept{return entries_.size();}
+
+        bool find(
+                KeyViewT key,
+                size_t &index)const noexcept
+        {
+            if(entries_.empty())
+                return false;
+            uint64_t hash = hashBytes(key.data(), key.length());
+            const EntryT &entry = entries_[slot(hash, seeds_[hashRange(hash, seeds_.size())])];
+            if(entry.length_ != key.length() || 0 != memcmp(entry.data_, key.data(), key.length()))
+                return false;
+            index = entry.index_;
+            return true;
+        }
+
+    private:
+        size_t slot(
+                uint64_t hash,
+                uint32_t seed)const noexcept
+        {
+            return hashRange(hashMix(hash ^ HASH_PRIME_1, HASH_PRIME_0 ^ (seed*HASH_PRIME_1)), entries_.size());
+        }
+
+    private:
+        EntriesT entries_;
+        SeedsT seeds_;
+        bool built_;
+    };
+
+}
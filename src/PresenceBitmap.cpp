@@ -0,0 +1,77 @@
+#include "PresenceBitmap.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define PRESENCE_BITMAP_X86_
+#endif
+
+using namespace st_suffix_tree::st_suffix_tree_impl;
+
+namespace{
+    typedef uint64_t (*StridedBitsFuncT)(const uint64_t *, size_t, size_t, size_t);
+
+    uint64_t stridedBitsScalar(
+            const uint64_t *words,
+            size_t first,
+            size_t stride,
+            size_t count)
+    {
+        uint64_t res = 0;
+        for(size_t i = 0, pos = first; i < count; ++i, pos += stride)
+            res |= ((words[pos / 64] >> (pos % 64)) & 1) << i;
+        return res;
+    }
+
+#ifdef PRESENCE_BITMAP_X86_
+    /// 4 positions per step: words are gathered by word indexes, bits are extracted by variable shifts
+    __attribute__((target("avx2")))
+    uint64_t stridedBitsAvx2(
+            const uint64_t *words,
+            size_t first,
+            size_t stride,
+            size_t count)
+    {
+        const __m256i step = _mm256_set1_epi64x(static_cast<long long>(4*stride));
+        const __m256i low = _mm256_set1_epi64x(63);
+        const __m256i one = _mm256_set1_epi64x(1);
+        __m256i pos = _mm256_add_epi64(
+                _mm256_set1_epi64x(static_cast<long long>(first)),
+                _mm256_setr_epi64x(0, static_cast<long long>(stride),
+                                   static_cast<long long>(2*stride), static_cast<long long>(3*stride)));
+        uint64_t res = 0;
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4){
+            __m256i gathered = _mm256_i64gather_epi64(
+                    reinterpret_cast<const long long *>(words), _mm256_srli_epi64(pos, 6), 8);
+            __m256i bits = _mm256_and_si256(_mm256_srlv_epi64(gathered, _mm256_and_si256(pos, low)), one);
+            uint64_t mask = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(bits, one))));
+            res |= mask << i;
+            pos = _mm256_add_epi64(pos, step);
+        }
+        if(i < count)
+            res |= stridedBitsScalar(words, first + i*stride, stride, count - i) << i;
+        return res;
+    }
+#endif
+
+    StridedBitsFuncT selectStridedBits()
+    {
+#ifdef PRESENCE_BITMAP_X86_
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2"))
+            return stridedBitsAvx2;
+#endif
+        return stridedBitsScalar;
+    }
+
+}
+
+uint64_t st_suffix_tree::st_suffix_tree_impl::stridedBits(
+        const uint64_t *words,
+        size_t first,
+        size_t stride,
+        size_t count)noexcept
+{
+    static const StridedBitsFuncT impl = selectStridedBits();
+    return impl(words, first, stride, count);
+}
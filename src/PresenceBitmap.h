@@ -0,0 +1,329 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+namespace st_suffix_tree{
+
+namespace st_suffix_tree_impl{
+
+    /// bit i of the result is bit first + i*stride of words, count <= 64.
+    /// Words are gathered by AVX2 if CPU supports it
+    uint64_t stridedBits(
+            const uint64_t *words,
+            size_t first,
+            size_t stride,
+            size_t count)noexcept;
+
+    /// Bitmap of occupied slots of the dense container. Bits are kept in 64-bit words,
+    /// summary bitmap has one bit per non-empty word, so first()/next() skip 4096 empty
+    /// slots per summary word. Counts of set bits of blocks of 4096 bits are kept in a Fenwick tree
+    /// updated by set()/reset() in O(log(blocks)), so countRange() takes 2 prefix sums of blocks
+    /// and popcounts at most 2 partial blocks.
+    /// Words are owned by the bitmap or attached from external memory (e.g. mapped file).
+    class PresenceBitmap{
+        typedef std::vector<uint64_t> WordsT;
+        typedef std::vector<uint64_t> BlockTreeT;
+
+        static constexpr size_t WORD_BITS = 64;
+        /// bits of the block, words of the block are bits of one summary word
+        static constexpr size_t BLOCK_BITS = WORD_BITS*WORD_BITS;
+
+    public:
+        static constexpr size_t NPOS = std::numeric_limits<size_t>::max();
+
+        PresenceBitmap():
+            bits_(nullptr), wordsSize_(0), size_(0), count_(0)
+        {}
+
+        explicit PresenceBitmap(size_t size)
+        {
+            assign(size);
+        }
+
+        /// copy owns its words even if words of bm are attached
+        PresenceBitmap(const PresenceBitmap &bm):
+            words_(bm.bits_, bm.bits_ + bm.wordsSize_), bits_(words_.data()), wordsSize_(bm.wordsSize_),
+            summary_(bm.summary_), blockTree_(bm.blockTree_), size_(bm.size_), count_(bm.count_)
+        {}
+
+        PresenceBitmap &operator=(PresenceBitmap bm)
+        {
+            swap(bm);
+            return *this;
+        }
+
+        void swap(PresenceBitmap &bm)noexcept
+        {
+            std::swap(words_, bm.words_);
+            std::swap(bits_, bm.bits_);
+            std::swap(wordsSize_, bm.wordsSize_);
+            std::swap(summary_, bm.summary_);
+            std::swap(blockTree_, bm.blockTree_);
+            std::swap(size_, bm.size_);
+            std::swap(count_, bm.count_);
+        }
+
+        /// resizes bitmap to size bits in own words, all bits are reset
+        void assign(size_t size)
+        {
+            words_.assign(wordsCount(size), 0);
+            bits_ = words_.data();
+            wordsSize_ = words_.size();
+            size_ = size;
+            rebuild();
+        }
+
+        /// resizes bitmap to size bits and copies bits from words,
+        /// own or attached words are reused if size is the same
+        void assign(
+                const uint64_t *words,
+                size_t size)
+        {
+            if(size != size_ || nullptr == bits_)
+                assign(size);
+            std::copy(words, words + wordsSize_, bits_);
+            if(0 != size % WORD_BITS && 0 != wordsSize_)
+                bits_[wordsSize_ - 1] &= bit(size) - 1;
+            rebuild();
+        }
+
+        /// uses wordsCount(size) words of external memory, which has to outlive the bitmap,
+        /// current content of the words is kept
+        void attach(
+                uint64_t *words,
+                size_t size)
+        {
+            WordsT().swap(words_);
+            bits_ = words;
+            wordsSize_ = wordsCount(size);
+            size_ = size;
+            rebuild();
+        }
+
+        /// uses wordsCount(size) words of external memory filled by zeros (e.g. fresh ReservedMemory),
+        /// words aren't read, so untouched pages stay uncommitted
+        void attachZeros(
+                uint64_t *words,
+                size_t size)
+        {
+            WordsT().swap(words_);
+            bits_ = words;
+            wordsSize_ = wordsCount(size);
+            size_ = size;
+            summary_.assign(wordsCount(wordsSize_), 0);
+            blockTree_.assign(summary_.size(), 0);
+            count_ = 0;
+        }
+
+        /// resets all bits, size and storage of words are kept.
+        /// Only non-empty words are written, so untouched pages of attached memory stay untouched
+        void clear()
+        {
+            for(size_t i = 0; i < summary_.size(); ++i){
+                for(uint64_t summary = summary_[i]; 0 != summary; summary &= summary - 1)
+                    bits_[i*WORD_BITS + __builtin_ctzll(summary)] = 0;
+                summary_[i] = 0;
+            }
+            std::fill(blockTree_.begin(), blockTree_.end(), 0);
+            count_ = 0;
+        }
+
+        size_t size()const noexcept{return size_;}
+
+        /// count of set bits
+        size_t count()const noexcept{return count_;}
+
+        bool test(size_t pos)const noexcept
+        {
+            return 0 != (bits_[pos / WORD_BITS] & bit(pos));
+        }
+
+        /// bit i of the result is set if bit first + i*stride is set, count <= 64
+        uint64_t testStrided(
+                size_t first,
+                size_t stride,
+                size_t count)const noexcept
+        {
+            return stridedBits(bits_, first, stride, count);
+        }
+
+        /// returns true if bit was not set
+        bool set(size_t pos)noexcept
+        {
+            uint64_t &word = bits_[pos / WORD_BITS];
+            if(0 != (word & bit(pos)))
+                return false;
+            if(0 == word)
+                summary_[pos / WORD_BITS / WORD_BITS] |= bit(pos / WORD_BITS);
+            word |= bit(pos);
+            addToBlock(pos / BLOCK_BITS, 1);
+            ++count_;
+            return true;
+        }
+
+        /// returns true if bit was set
+        bool reset(size_t pos)noexcept
+        {
+            uint64_t &word = bits_[pos / WORD_BITS];
+            if(0 == (word & bit(pos)))
+                return false;
+            word &= ~bit(pos);
+            if(0 == word)
+                summary_[pos / WORD_BITS / WORD_BITS] &= ~bit(pos / WORD_BITS);
+            addToBlock(pos / BLOCK_BITS, ~0ull);
+            --count_;
+            return true;
+        }
+
+        /// position of the first set bit or NPOS
+        size_t first()const noexcept
+        {
+            return nextWord(0);
+        }
+
+        /// position of the first set bit after pos or NPOS
+        size_t next(size_t pos)const noexcept
+        {
+            ++pos;
+            if(pos >= size_)
+                return NPOS;
+            size_t wordIdx = pos / WORD_BITS;
+            uint64_t word = bits_[wordIdx] & (~0ull << (pos % WORD_BITS));
+            if(0 != word)
+                return wordIdx*WORD_BITS + __builtin_ctzll(word);
+            return nextWord(wordIdx + 1);
+        }
+
+        /// count of set bits in [from, to): O(log(blocks)) prefix sums of block counts
+        /// and popcounts of non-empty words of the first and the last blocks
+        size_t countRange(
+                size_t from,
+                size_t to)const noexcept
+        {
+            to = std::min(to, size_);
+            if(from >= to)
+                return 0;
+            size_t firstBlock = from / BLOCK_BITS;
+            size_t lastBlock = (to - 1) / BLOCK_BITS;
+            if(firstBlock == lastBlock)
+                return countInBlock(from, to);
+            size_t res = countInBlock(from, (firstBlock + 1)*BLOCK_BITS);
+            res += countBlocks(lastBlock) - countBlocks(firstBlock + 1);
+            return res + countInBlock(lastBlock*BLOCK_BITS, to);
+        }
+
+        /// wordsSize() words with bits of the bitmap
+        const uint64_t *words()const noexcept{return bits_;}
+
+        size_t wordsSize()const noexcept{return wordsSize_;}
+
+        /// count of words needed for bits
+        static size_t wordsCount(size_t bits)noexcept
+        {
+            return (bits + WORD_BITS - 1) / WORD_BITS;
+        }
+
+    private:
+        static uint64_t bit(size_t pos)noexcept
+        {
+            return 1ull << (pos % WORD_BITS);
+        }
+
+        /// recalculates summary, block counts and count from words
+        void rebuild()
+        {
+            summary_.assign(wordsCount(wordsSize_), 0);
+            blockTree_.assign(summary_.size(), 0);
+            count_ = 0;
+            for(size_t i = 0; i < wordsSize_; ++i){
+                if(0 == bits_[i])
+                    continue;
+                summary_[i / WORD_BITS] |= bit(i);
+                blockTree_[i / WORD_BITS] += __builtin_popcountll(bits_[i]);
+                count_ += __builtin_popcountll(bits_[i]);
+            }
+            /// block counts are turned into the Fenwick tree in place
+            for(size_t i = 1; i <= blockTree_.size(); ++i){
+                size_t parent = i + (i & (0 - i));
+                if(parent <= blockTree_.size())
+                    blockTree_[parent - 1] += blockTree_[i - 1];
+            }
+        }
+
+        /// adds delta (modulo 2^64) to the count of block
+        void addToBlock(
+                size_t block,
+                uint64_t delta)noexcept
+        {
+            for(size_t i = block + 1; i <= blockTree_.size(); i += i & (0 - i))
+                blockTree_[i - 1] += delta;
+        }
+
+        /// count of set bits in blocks [0, blocks)
+        size_t countBlocks(size_t blocks)const noexcept
+        {
+            size_t res = 0;
+            for(size_t i = blocks; 0 != i; i &= i - 1)
+                res += blockTree_[i - 1];
+            return res;
+        }
+
+        /// position of the first set bit in words starting from wordIdx
+        size_t nextWord(size_t wordIdx)const noexcept
+        {
+            size_t summaryIdx = wordIdx / WORD_BITS;
+            if(summaryIdx >= summary_.size())
+                return NPOS;
+            uint64_t summary = summary_[summaryIdx] & (~0ull << (wordIdx % WORD_BITS));
+            while(0 == summary){
+                if(++summaryIdx >= summary_.size())
+                    return NPOS;
+                summary = summary_[summaryIdx];
+            }
+            wordIdx = summaryIdx*WORD_BITS + __builtin_ctzll(summary);
+            return wordIdx*WORD_BITS + __builtin_ctzll(bits_[wordIdx]);
+        }
+
+        /// count of set bits in [from, to), both positions are inside of one block
+        size_t countInBlock(
+                size_t from,
+                size_t to)const noexcept
+        {
+            size_t firstWord = from / WORD_BITS;
+            size_t lastWord = (to - 1) / WORD_BITS;
+            uint64_t summary = summary_[firstWord / WORD_BITS];
+            summary &= ~0ull << (firstWord % WORD_BITS);
+            if(lastWord % WORD_BITS != WORD_BITS - 1)
+                summary &= (bit(lastWord) << 1) - 1;
+            size_t res = 0;
+            for(; 0 != summary; summary &= summary - 1){
+                size_t wordIdx = (firstWord / WORD_BITS)*WORD_BITS + __builtin_ctzll(summary);
+                uint64_t word = bits_[wordIdx];
+                if(wordIdx == firstWord)
+                    word &= ~0ull << (from % WORD_BITS);
+                if(wordIdx == lastWord && 0 != to % WORD_BITS)
+                    word &= bit(to) - 1;
+                res += __builtin_popcountll(word);
+            }
+            return res;
+        }
+
+    private:
+        WordsT words_;
+        /// words_.data() or attached memory
+        uint64_t *bits_;
+        size_t wordsSize_;
+        WordsT summary_;
+        /// Fenwick tree of counts of set bits of blocks of BLOCK_BITS bits
+        BlockTreeT blockTree_;
+        size_t size_;
+        size_t count_;
+    };
+
+}
+
+}
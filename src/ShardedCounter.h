@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <functional>
+
+namespace suffix_tree{
+
+    namespace suffix_tree_impl{
+
+        /// counter updated by many threads, every thread works with its own cache line
+        class ShardedCounter{
+        public:
+            static constexpr size_t SHARDS_COUNT = 16;
+
+            ShardedCounter() = default;
+            ShardedCounter(const ShardedCounter &) = delete;
+            ShardedCounter &operator=(const ShardedCounter &) = delete;
+
+            void add(long long val)noexcept
+            {
+                shards_[shard()].value_.fetch_add(val, std::memory_order_relaxed);
+            }
+
+            size_t load()const noexcept
+            {
+                long long res = 0;
+                for(auto &val: shards_)
+                    res += val.value_.load(std::memory_order_relaxed);
+                return (res > 0)? static_cast<size_t>(res): 0;
+            }
+
+            /// has to be called when there are no concurrent add()
+            void reset()noexcept
+            {
+                for(auto &val: shards_)
+                    val.value_.store(0, std::memory_order_relaxed);
+            }
+
+        private:
+            static size_t shard()noexcept
+            {
+                static thread_local size_t idx = std::hash<std::thread::id>()(std::this_thread::get_id()) % SHARDS_COUNT;
+                return idx;
+            }
+
+        private:
+            struct alignas(64) ShardT{
+                std::atomic<long long> value_{0};
+            };
+            ShardT shards_[SHARDS_COUNT];
+        };
+
+    }
+
+}
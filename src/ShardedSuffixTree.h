@@ -0,0 +1,277 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <future>
+#include <functional>
+
+#include "SuffixTree.h"
+#include "SpscQueue.h"
+#include "hpUtils.h"
+
+namespace suffix_tree{
+
+    /// Shared nothing container: index space of the root level is split into shardsCount contiguous
+    /// ranges, every range is owned by the shard thread with its own SuffixTree and allocator.
+    /// Router methods parse key once and pass the operation to the owning shard through its SPSC queue,
+    /// result is delivered by the future or by the callback, which is called on the shard thread.
+    /// Router methods have to be called from one thread. Keys with unknown subkeys are rejected,
+    /// so traits have to be filled before the container is created.
+    template<class ContTraitsT>
+    class ShardedSuffixTree
+    {
+    public:
+        typedef ContTraitsT TraitsT;
+        typedef typename TraitsT::KeyT KeyT;
+        typedef typename TraitsT::KeyViewT KeyViewT;
+        typedef typename TraitsT::ParsedKeyT ParsedKeyT;
+        typedef typename TraitsT::ValueT ValueT;
+        typedef SuffixTree<TraitsT> TreeT;
+        /// first is true if key was inserted/found/erased, second is found value
+        typedef std::pair<bool, ValueT> ResultT;
+        typedef std::function<void(const ResultT &)> CallbackT;
+        typedef std::function<void(size_t, const ResultT &)> BatchCallbackT;
+
+        enum OperationType{
+            insert_Op = 0,
+            find_Op,
+            erase_Op,
+            barrier_Op
+        };
+
+        static constexpr size_t DEFAULT_QUEUE_CAPACITY = 4096;
+
+    private:
+        struct OperationT{
+            OperationType type_ = barrier_Op;
+            ParsedKeyT key_;
+            ValueT value_ = ValueT();
+            CallbackT callback_;
+        };
+        typedef suffix_tree_impl::SpscQueue<OperationT> QueueT;
+
+        struct alignas(64) ShardT{
+            explicit ShardT(size_t queueCapacity):
+                queue_(queueCapacity), stop_(false), size_(0)
+            {}
+
+            QueueT queue_;
+            alignas(64) std::atomic<bool> stop_;
+            std::atomic<size_t> size_;
+            std::thread thread_;
+        };
+        typedef std::unique_ptr<ShardT> ShardPtrT;
+
+    public:
+        /// shard i is pinned to the core (firstCpu + i) % cores if pinThreads is set
+        ShardedSuffixTree(
+                const TraitsT &traits,
+                size_t shardsCount,
+                bool pinThreads = true,
+                size_t firstCpu = 0,
+                size_t queueCapacity = DEFAULT_QUEUE_CAPACITY):
+            traits_(traits),
+            rootCount_(traits_.suffixCount(static_cast<typename TraitsT::SuffixLevel>(0)))
+        {
+            if(0 == shardsCount)
+                throw std::runtime_error("ShardedSuffixTree::ShardedSuffixTree: count of shards has to be positive");
+            size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+            shards_.reserve(shardsCount);
+            try{
+                for(size_t i = 0; i < shardsCount; ++i){
+                    shards_.emplace_back(new ShardT(queueCapacity));
+                    ShardT *shard = shards_.back().get();
+                    long cpuId = pinThreads? static_cast<long>((firstCpu + i) % cores): -1;
+                    shard->thread_ = std::thread([this, shard, cpuId](){run(*shard, cpuId);});
+                }
+            }catch(...){
+                stop();
+                throw;
+            }
+        }
+
+        /// waits until all submitted operations are processed
+        ~ShardedSuffixTree()
+        {
+            stop();
+        }
+
+        ShardedSuffixTree(const ShardedSuffixTree &) = delete;
+        ShardedSuffixTree &operator=(const ShardedSuffixTree &) = delete;
+
+        std::future<ResultT> insert(
+                KeyViewT key,
+                const ValueT &val)
+        {
+            return submit(insert_Op, key, val);
+        }
+
+        std::future<ResultT> find(KeyViewT key)
+        {
+            return submit(find_Op, key, ValueT());
+        }
+
+        std::future<ResultT> erase(KeyViewT key)
+        {
+            return submit(erase_Op, key, ValueT());
+        }
+
+        /// returns false and calls callback immediately if the key can't be parsed
+        bool submit(
+                OperationType type,
+                KeyViewT key,
+                const ValueT &val,
+                CallbackT callback)
+        {
+            OperationT op;
+            op.type_ = type;
+            op.value_ = val;
+            op.callback_ = std::move(callback);
+            if(barrier_Op == type || !traits_.parseKey(key, op.key_)){
+                op.callback_(ResultT(false, ValueT()));
+                return false;
+            }
+            enqueue(shardOf(op.key_), std::move(op));
+            return true;
+        }
+
+        /// values can be nullptr for find and erase, callback gets index of the key in keys
+        size_t submit_batch(
+                OperationType type,
+                const KeyViewT *keys,
+                const ValueT *values,
+                size_t count,
+                const BatchCallbackT &callback)
+        {
+            size_t submitted = 0;
+            for(size_t i = 0; i < count; ++i){
+                auto cb = [callback, i](const ResultT &res){callback(i, res);};
+                if(submit(type, keys[i], (nullptr != values)? values[i]: ValueT(), cb))
+                    ++submitted;
+            }
+            return submitted;
+        }
+
+        /// waits until all shards process operations submitted before
+        void flush()
+        {
+            std::vector<std::future<ResultT>> done;
+            done.reserve(shards_.size());
+            for(size_t i = 0; i < shards_.size(); ++i){
+                auto promise = std::make_shared<std::promise<ResultT>>();
+                done.push_back(promise->get_future());
+                OperationT op;
+                op.callback_ = [promise](const ResultT &res){promise->set_value(res);};
+                enqueue(i, std::move(op));
+            }
+            for(auto &f: done)
+                f.wait();
+        }
+
+        /// count of keys in shards, operations in queues aren't counted
+        size_t size()const noexcept
+        {
+            size_t res = 0;
+            for(auto &shard: shards_)
+                res += shard->size_.load(std::memory_order_relaxed);
+            return res;
+        }
+
+        size_t shards()const noexcept{return shards_.size();}
+
+        size_t shardOf(const ParsedKeyT &key)const noexcept
+        {
+            return key[0] * shards_.size() / rootCount_;
+        }
+
+        const TraitsT &traits()const noexcept{return traits_;}
+
+    private:
+        std::future<ResultT> submit(
+                OperationType type,
+                KeyViewT key,
+                const ValueT &val)
+        {
+            auto promise = std::make_shared<std::promise<ResultT>>();
+            auto res = promise->get_future();
+            submit(type, key, val, [promise](const ResultT &r){promise->set_value(r);});
+            return res;
+        }
+
+        /// stops and joins started shard threads
+        void stop()
+        {
+            for(auto &shard: shards_)
+                shard->stop_.store(true, std::memory_order_release);
+            for(auto &shard: shards_){
+                if(shard->thread_.joinable())
+                    shard->thread_.join();
+            }
+        }
+
+        void enqueue(
+                size_t shardIdx,
+                OperationT &&op)
+        {
+            QueueT &queue = shards_[shardIdx]->queue_;
+            while(!queue.push(std::move(op)))
+                std::this_thread::yield();
+        }
+
+        void run(
+                ShardT &shard,
+                long cpuId)
+        {
+            if(cpuId >= 0)
+                hptimer::setProcessAffinity(static_cast<int>(cpuId));
+            TreeT tree(traits_);
+            OperationT op;
+            while(true){
+                bool stop = shard.stop_.load(std::memory_order_acquire);
+                if(!shard.queue_.pop(op)){
+                    if(stop)
+                        break;
+                    std::this_thread::yield();
+                    continue;
+                }
+                op.callback_(apply(tree, op));
+                op.callback_ = nullptr;
+                shard.size_.store(tree.size(), std::memory_order_relaxed);
+            }
+        }
+
+        static ResultT apply(
+                TreeT &tree,
+                const OperationT &op)
+        {
+            switch(op.type_){
+                case insert_Op:
+                    return ResultT(tree.end() != tree.insert(op.key_, op.value_), op.value_);
+                case find_Op:{
+                    auto it = tree.find(op.key_);
+                    if(tree.end() == it)
+                        return ResultT(false, ValueT());
+                    return ResultT(true, it.value());
+                }
+                case erase_Op:{
+                    auto it = tree.find(op.key_);
+                    if(tree.end() == it)
+                        return ResultT(false, ValueT());
+                    ValueT val = it.value();
+                    tree.erase(it);
+                    return ResultT(true, val);
+                }
+                default:
+                    return ResultT(true, ValueT());
+            }
+        }
+
+    private:
+        TraitsT traits_;
+        size_t rootCount_;
+        std::vector<ShardPtrT> shards_;
+    };
+
+}
@@ -0,0 +1,57 @@
+#include "ShortKeyIndex.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace aux;
+
+ShortKeyIndex::ShortKeyIndex():
+    size_(0)
+{
+}
+
+void ShortKeyIndex::insert(
+        KeyViewT key,
+        size_t index)
+{
+    assert(isShort(key));
+    /// load factor is kept below 1/2, so probe sequences stay short
+    if(entries_.size() < 2*(size_ + 1))
+        rehash(std::max(MIN_CAPACITY, 2*entries_.size()));
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+    encode(key, lo, hi);
+    size_t mask = entries_.size() - 1;
+    size_t pos = hash(lo, hi) & mask;
+    for(; 0 != entries_[pos].hi_; pos = (pos + 1) & mask){
+        if(entries_[pos].lo_ == lo && entries_[pos].hi_ == hi){
+            entries_[pos].index_ = index;
+            return;
+        }
+    }
+    entries_[pos] = EntryT{lo, hi, index};
+    ++size_;
+}
+
+void ShortKeyIndex::clear()noexcept
+{
+    EntriesT tmp;
+    std::swap(tmp, entries_);
+    size_ = 0;
+}
+
+void ShortKeyIndex::rehash(
+        size_t capacity)
+{
+    EntriesT oldEntries(capacity, EntryT{0, 0, 0});
+    std::swap(oldEntries, entries_);
+    size_t mask = entries_.size() - 1;
+    for(auto &entry: oldEntries){
+        if(0 == entry.hi_)
+            continue;
+        size_t pos = hash(entry.lo_, entry.hi_) & mask;
+        while(0 != entries_[pos].hi_)
+            pos = (pos + 1) & mask;
+        entries_[pos] = entry;
+    }
+}
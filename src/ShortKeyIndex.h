@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include "HashUtils.h"
+
+namespace aux {
+
+    /// Map from short subkey to its index. Subkey of up to MAX_LENGTH bytes is packed into two
+    /// integers: zero padded bytes and length + 1 in the top byte, so lookup is a hash of two words
+    /// and integer compares in the open addressing table, no string compare is needed.
+    class ShortKeyIndex{
+        struct EntryT{
+            uint64_t lo_;
+            uint64_t hi_;   /// 0 for empty entry
+            size_t index_;
+        };
+        typedef std::vector<EntryT> EntriesT;
+
+        static constexpr size_t MIN_CAPACITY = 16;
+
+    public:
+        typedef std::string_view KeyViewT;
+
+        static constexpr size_t MAX_LENGTH = 15;
+
+        ShortKeyIndex();
+
+        static bool isShort(
+                KeyViewT key)noexcept
+        {
+            return key.length() <= MAX_LENGTH;
+        }
+
+        size_t size()const noexcept{return size_;}
+
+        /// key has to be short
+        bool find(
+                KeyViewT key,
+                size_t &index)const noexcept
+        {
+            if(entries_.empty())
+                return false;
+            uint64_t lo = 0;
+            uint64_t hi = 0;
+            encode(key, lo, hi);
+            size_t mask = entries_.size() - 1;
+            for(size_t pos = hash(lo, hi) & mask;; pos = (pos + 1) & mask){
+                const EntryT &entry = entries_[pos];
+                if(entry.lo_ == lo && entry.hi_ == hi){
+                    index = entry.index_;
+                    return true;
+                }
+                if(0 == entry.hi_)
+                    return false;
+            }
+        }
+
+        /// adds short key or updates its index
+        void insert(
+                KeyViewT key,
+                size_t index);
+
+        void clear()noexcept;
+
+    private:
+        static void encode(
+                KeyViewT key,
+                uint64_t &lo,
+                uint64_t &hi)noexcept
+        {
+            char buffer[16] = {};
+            memcpy(buffer, key.data(), key.length());
+            buffer[15] = static_cast<char>(key.length() + 1);
+            memcpy(&lo, buffer, 8);
+            memcpy(&hi, buffer + 8, 8);
+        }
+
+        static size_t hash(
+                uint64_t lo,
+                uint64_t hi)noexcept
+        {
+            return hashMix(lo ^ HASH_PRIME_0, hi ^ HASH_PRIME_1);
+        }
+
+        void rehash(
+                size_t capacity);
+
+    private:
+        EntriesT entries_;
+        size_t size_;
+    };
+
+}
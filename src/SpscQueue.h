@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+
+namespace suffix_tree{
+
+    namespace suffix_tree_impl{
+
+        /// bounded lock free queue for one producer thread and one consumer thread.
+        /// Producer and consumer positions live on different cache lines, every side caches
+        /// the position of the other one and rereads it only when the queue looks full/empty
+        template<typename ValueT>
+        class SpscQueue{
+        public:
+            explicit SpscQueue(size_t capacity):
+                buffer_(capacity), mask_(capacity - 1)
+            {
+                if(0 == capacity || 0 != (capacity & (capacity - 1)))
+                    throw std::runtime_error("SpscQueue::SpscQueue: capacity has to be power of 2");
+            }
+
+            SpscQueue(const SpscQueue &) = delete;
+            SpscQueue &operator=(const SpscQueue &) = delete;
+
+            /// producer side
+            bool push(ValueT &&val)
+            {
+                size_t tail = tail_.load(std::memory_order_relaxed);
+                if(tail - cachedHead_ > mask_){
+                    cachedHead_ = head_.load(std::memory_order_acquire);
+                    if(tail - cachedHead_ > mask_)
+                        return false;
+                }
+                buffer_[tail & mask_] = std::move(val);
+                tail_.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            /// consumer side
+            bool pop(ValueT &val)
+            {
+                size_t head = head_.load(std::memory_order_relaxed);
+                if(head == cachedTail_){
+                    cachedTail_ = tail_.load(std::memory_order_acquire);
+                    if(head == cachedTail_)
+                        return false;
+                }
+                val = std::move(buffer_[head & mask_]);
+                head_.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            size_t capacity()const noexcept{return buffer_.size();}
+
+        private:
+            std::vector<ValueT> buffer_;
+            size_t mask_;
+            alignas(64) std::atomic<size_t> tail_{0};
+            size_t cachedHead_ = 0; ///producer only
+            alignas(64) std::atomic<size_t> head_{0};
+            size_t cachedTail_ = 0; ///consumer only
+        };
+
+    }
+
+}
@@ -1,4 +1,5 @@
 #include "StaticContBuilder.h"
+#include "KeyTokenizer.h"
 #include <cstring>
 
 using namespace st_suffix_tree;
@@ -40,6 +41,9 @@ StaticContBuilder::StaticContBuilder(
     std::sort(std::begin(meta_[1]), std::end(meta_[1]));
     std::sort(std::begin(meta_[2]), std::end(meta_[2]));
     std::sort(std::begin(meta_[3]), std::end(meta_[3]));
+    levelIndex_.reserve(meta_.size());
+    for(auto &levelKeys: meta_)
+        levelIndex_.emplace_back(levelKeys);
 }
 
 StaticContBuilder::~StaticContBuilder()
@@ -51,54 +55,68 @@ size_t StaticContBuilder::suffixCount(
     return meta_[level].size();
 }
 
+std::vector<KeyViewT> StaticContBuilder::subkeys(
+            size_t level)const
+{
+    return std::vector<KeyViewT>(std::begin(meta_[level]), std::end(meta_[level]));
+}
+
 bool StaticContBuilder::getKeyIndex(
             size_t level, 
-            const KeyT &key, 
+            KeyViewT key,
             size_t startIdx, 
             size_t endIdx,
             st_suffix_tree::st_suffix_tree_impl::IndexT &index)const
 {
-    const Key2IdxT &levelKeys = meta_[level];
-    const char *pVal = key.c_str() + startIdx;
-    size_t count = endIdx - startIdx;
-    auto keyIt = std::lower_bound(
-            std::begin(levelKeys), std::end(levelKeys), key, 
-            [&](const Key2IdxT::value_type &lft, const KeyT &key)->bool
-            {
-                return 0 > strncmp(lft.c_str(), pVal, count);
-            });
-    if(std::end(levelKeys) == keyIt || 
-       0 != strncmp(keyIt->c_str(), pVal, count))
-        return false;
-    index = keyIt - std::begin(levelKeys);
-    return true;
+    return levelIndex_[level].find(KeyViewT(key.data() + startIdx, endIdx - startIdx), meta_[level], index);
 }
 
 bool StaticContBuilder::parseKey(
-            const KeyT &key, 
+            const char *key,
+            size_t length,
             StaticContBuilder::ParsedKeyT &res)const
 {
-    size_t currLevel = 0;
+    return parseKey(KeyViewT(key, length), res);
+}
+
+bool StaticContBuilder::parseKey(
+            KeyViewT key,
+            StaticContBuilder::ParsedKeyT &res)const
+{
+    size_t tokenLastPosition[leaf_Suffix + 1];
+    if(leaf_Suffix != aux::findDelimiters(key.data(), key.length(), delimeter_, tokenLastPosition, leaf_Suffix))
+        return false;
+    tokenLastPosition[leaf_Suffix] = key.length();
     size_t startIdx = 0;
-    size_t totalLen = key.length();
-    for(size_t i = 0; i < totalLen; ++i){
-        if(delimeter_ == key[i]){
-            st_suffix_tree::st_suffix_tree_impl::IndexT index = 0;
-            if(!getKeyIndex(currLevel, key, startIdx, i, index))
-                return false;
-            res[currLevel] = index;
-            ++currLevel;
-            startIdx = i + 1; ///skip delimeter
-        }
-    }
-    if(startIdx < totalLen){
+    for(size_t i = 0; i <= leaf_Suffix; ++i){
         st_suffix_tree::st_suffix_tree_impl::IndexT index = 0;
-        if(!getKeyIndex(currLevel, key, startIdx, totalLen, index))
+        if(!getKeyIndex(i, key, startIdx, tokenLastPosition[i], index))
+            return false;
+        res[i] = index;
+        startIdx = tokenLastPosition[i] + 1; ///skip delimeter
+    }
+    return true;
+}
+
+StaticContBuilder::ParsedKeyT StaticContBuilder::parseKey(
+            KeyViewT key)const
+{
+    ParsedKeyT res;
+    if(!parseKey(key, res))
+        res.fill(st_suffix_tree::st_suffix_tree_impl::INVALID_INDEX);
+    return res;
+}
+
+bool StaticContBuilder::isValid(
+            const ParsedKeyT &key)const noexcept
+{
+    for(size_t i = 0; i < key.size(); ++i){
+        if(key[i] >= meta_[i].size())
             return false;
-        res[currLevel] = index;
     }
     return true;
 }
+
 KeyT StaticContBuilder::assembleKey(
             const ParsedKeyT &key)
 {
@@ -2,9 +2,13 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <array>
 #include "StaticSuffixTree.h"
+#include "EytzingerIndex.h"
 
 typedef std::string KeyT;
+typedef std::string_view KeyViewT;
 typedef std::vector<KeyT> Key2IdxT;
 
 typedef std::vector<Key2IdxT> MetaDataPerLevelsT;
@@ -13,6 +17,7 @@ class StaticContBuilder
 {
 public:
     typedef int ValueT;
+    typedef ::KeyViewT KeyViewT;
 public:
     enum SuffixLevel{
         root_Suffix = 0,
@@ -20,7 +25,7 @@ public:
         second_Suffix,
         leaf_Suffix
     };
-    typedef st_suffix_tree::st_suffix_tree_impl::IndexT ParsedKeyT[leaf_Suffix + 1];
+    typedef std::array<st_suffix_tree::st_suffix_tree_impl::IndexT, leaf_Suffix + 1> ParsedKeyT;
 
     StaticContBuilder(
             const Key2IdxT &lvl1,
@@ -31,25 +36,41 @@ public:
     ~StaticContBuilder();
 
     bool parseKey(
-            const KeyT &key, 
+            KeyViewT key,
             StaticContBuilder::ParsedKeyT &res)const;
+    bool parseKey(
+            const char *key,
+            size_t length,
+            StaticContBuilder::ParsedKeyT &res)const;
+    /// returns indexes of subkeys, all indexes are INVALID_INDEX if key is unknown
+    ParsedKeyT parseKey(
+            KeyViewT key)const;
+    bool isValid(
+            const ParsedKeyT &key)const noexcept;
     KeyT assembleKey(
             const ParsedKeyT &key);
 
     size_t suffixCount(
             SuffixLevel level)const;
 
+    /// subkeys of the level ordered by index
+    std::vector<KeyViewT> subkeys(
+            size_t level)const;
+
+    char delimeter()const noexcept{return delimeter_;}
+
     static ValueT defaultValue(){return ValueT();}
 
 protected:
     bool getKeyIndex(
             size_t level, 
-            const KeyT &key, 
+            KeyViewT key,
             size_t startIdx, 
             size_t endIdx,
             st_suffix_tree::st_suffix_tree_impl::IndexT &index)const;
 private:
 
     MetaDataPerLevelsT meta_;
+    std::vector<st_suffix_tree::EytzingerIndex> levelIndex_;
     char delimeter_;
 };
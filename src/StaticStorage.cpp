@@ -0,0 +1,176 @@
+#include "StaticStorage.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace st_suffix_tree::st_suffix_tree_impl;
+
+namespace{
+    const char GRID_MAGIC[8] = {'S', 'F', 'X', 'G', 'R', 'I', 'D', '\0'};
+    const uint32_t GRID_VERSION = 1;
+    static_assert(sizeof(GridFileHeader) <= GRID_HEADER_SIZE);
+}
+
+GridFileHeader st_suffix_tree::st_suffix_tree_impl::makeGridFileHeader(
+        size_t valueSize,
+        size_t slots,
+        uint64_t layout)
+{
+    GridFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic_, GRID_MAGIC, sizeof(GRID_MAGIC));
+    header.version_ = GRID_VERSION;
+    header.valueSize_ = static_cast<uint32_t>(valueSize);
+    header.slots_ = slots;
+    header.layout_ = layout;
+    return header;
+}
+
+GridFile::GridFile():
+    data_(nullptr), size_(0)
+{}
+
+GridFile::~GridFile()
+{
+    close();
+}
+
+GridFile::GridFile(GridFile &&file)noexcept:
+    data_(std::exchange(file.data_, nullptr)), size_(std::exchange(file.size_, 0))
+{}
+
+GridFile &GridFile::operator=(GridFile &&file)noexcept
+{
+    if(this != &file){
+        close();
+        data_ = std::exchange(file.data_, nullptr);
+        size_ = std::exchange(file.size_, 0);
+    }
+    return *this;
+}
+
+bool GridFile::open(
+        const std::string &path,
+        const GridFileHeader &header,
+        size_t size)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd < 0)
+        throw std::runtime_error("GridFile::open: unable to open " + path);
+    struct stat st;
+    if(0 != ::fstat(fd, &st)){
+        ::close(fd);
+        throw std::runtime_error("GridFile::open: unable to stat " + path);
+    }
+    bool restored = 0 != st.st_size;
+    if(restored){
+        GridFileHeader fileHeader;
+        if(static_cast<size_t>(st.st_size) != size
+                || sizeof(fileHeader) != ::pread(fd, &fileHeader, sizeof(fileHeader), 0)
+                || 0 != std::memcmp(&fileHeader, &header, sizeof(header))){
+            ::close(fd);
+            throw std::runtime_error("GridFile::open: layout of " + path + " differs from container");
+        }
+    }else{
+        /// new file is prepared under temporary name and renamed with the header written,
+        /// so a crash leaves the empty file, which is created again by the next open
+        ::close(fd);
+        std::string tmpPath = path + ".tmp";
+        fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0)
+            throw std::runtime_error("GridFile::open: unable to open " + tmpPath);
+        if(0 != ::ftruncate(fd, static_cast<off_t>(size))
+                || sizeof(header) != ::pwrite(fd, &header, sizeof(header), 0)
+                || 0 != ::fsync(fd)
+                || 0 != ::rename(tmpPath.c_str(), path.c_str())){
+            ::close(fd);
+            ::unlink(tmpPath.c_str());
+            throw std::runtime_error("GridFile::open: unable to create " + path);
+        }
+    }
+    void *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(MAP_FAILED == ptr)
+        throw std::runtime_error("GridFile::open: unable to map " + path);
+    data_ = static_cast<char *>(ptr);
+    size_ = size;
+    return restored;
+}
+
+void GridFile::sync()const
+{
+    if(nullptr != data_ && 0 != ::msync(data_, size_, MS_SYNC))
+        throw std::runtime_error("GridFile::sync: msync failed");
+}
+
+void GridFile::close()noexcept
+{
+    if(nullptr != data_)
+        ::munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+ReservedMemory::ReservedMemory():
+    data_(nullptr), size_(0)
+{}
+
+ReservedMemory::~ReservedMemory()
+{
+    unmap();
+}
+
+ReservedMemory::ReservedMemory(ReservedMemory &&memory)noexcept:
+    data_(std::exchange(memory.data_, nullptr)), size_(std::exchange(memory.size_, 0))
+{}
+
+ReservedMemory &ReservedMemory::operator=(ReservedMemory &&memory)noexcept
+{
+    if(this != &memory){
+        unmap();
+        data_ = std::exchange(memory.data_, nullptr);
+        size_ = std::exchange(memory.size_, 0);
+    }
+    return *this;
+}
+
+void ReservedMemory::reserve(size_t size)
+{
+    unmap();
+    if(0 == size)
+        return;
+    void *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(MAP_FAILED == ptr)
+        throw std::runtime_error("ReservedMemory::reserve: unable to reserve address space");
+    data_ = static_cast<char *>(ptr);
+    size_ = size;
+}
+
+void ReservedMemory::release(
+        size_t offset,
+        size_t size)noexcept
+{
+    if(nullptr != data_ && offset < size_)
+        ::madvise(data_ + offset, std::min(size, size_ - offset), MADV_DONTNEED);
+}
+
+size_t ReservedMemory::pageSize()noexcept
+{
+    static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+void ReservedMemory::unmap()noexcept
+{
+    if(nullptr != data_)
+        ::munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <type_traits>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#include "PresenceBitmap.h"
+
+namespace st_suffix_tree{
+
+namespace st_suffix_tree_impl{
+
+    /// First page of the file of MappedFileStorage, words of the presence bitmap start at the
+    /// next page, values follow the words
+    struct GridFileHeader{
+        char magic_[8];
+        uint32_t version_;
+        uint32_t valueSize_;
+        uint64_t slots_;
+        uint64_t layout_;          ///hash of dictionaries, see StaticSuffixTree
+    };
+
+    const size_t GRID_HEADER_SIZE = 4096;
+
+    GridFileHeader makeGridFileHeader(
+            size_t valueSize,
+            size_t slots,
+            uint64_t layout);
+
+    /// read-write shared mapping of the whole file
+    class GridFile{
+    public:
+        GridFile();
+        ~GridFile();
+
+        GridFile(GridFile &&file)noexcept;
+        GridFile &operator=(GridFile &&file)noexcept;
+
+        GridFile(const GridFile &) = delete;
+        GridFile &operator=(const GridFile &) = delete;
+
+        /// maps the file of size bytes. Missing or empty file is created filled by zeros and false
+        /// is returned, existing file is mapped as is and true is returned.
+        /// Throws std::runtime_error if header or size of existing file differ
+        bool open(
+                const std::string &path,
+                const GridFileHeader &header,
+                size_t size);
+
+        char *data()const noexcept{return data_;}
+        size_t size()const noexcept{return size_;}
+
+        /// writes dirty pages to the file synchronously
+        void sync()const;
+
+    private:
+        void close()noexcept;
+
+    private:
+        char *data_;
+        size_t size_;
+    };
+
+    /// anonymous private mapping reserved with MAP_NORESERVE: pages are zeros and physical
+    /// memory is committed by the first write to the page only
+    class ReservedMemory{
+    public:
+        ReservedMemory();
+        ~ReservedMemory();
+
+        ReservedMemory(ReservedMemory &&memory)noexcept;
+        ReservedMemory &operator=(ReservedMemory &&memory)noexcept;
+
+        ReservedMemory(const ReservedMemory &) = delete;
+        ReservedMemory &operator=(const ReservedMemory &) = delete;
+
+        /// reserves size bytes of address space, previous reservation is released
+        void reserve(size_t size);
+
+        /// returns pages of [offset, offset + size) to OS, they are read as zeros afterwards
+        void release(
+                size_t offset,
+                size_t size)noexcept;
+
+        char *data()const noexcept{return data_;}
+        size_t size()const noexcept{return size_;}
+
+        static size_t pageSize()noexcept;
+
+    private:
+        void unmap()noexcept;
+
+    private:
+        char *data_;
+        size_t size_;
+    };
+
+}
+
+/// Storage policies of StaticSuffixTree: memory for values and words of the presence bitmap.
+/// open() allocates arrays for slots and returns true if previous content is restored,
+/// touch() is called before the first write of the value and of the word of the slot.
+
+/// arrays in the heap, content is lost with the container
+template<typename ValueT>
+class VectorStorage{
+public:
+    bool open(
+            size_t slots,
+            uint64_t,
+            const ValueT &defaultValue)
+    {
+        words_.assign(st_suffix_tree_impl::PresenceBitmap::wordsCount(slots), 0);
+        values_.assign(slots, defaultValue);
+        return false;
+    }
+
+    ValueT *values()const noexcept{return values_.data();}
+    uint64_t *words()noexcept{return words_.data();}
+
+    void touch(size_t)noexcept
+    {}
+
+    void clearValues(const ValueT &defaultValue)
+    {
+        std::fill(values_.begin(), values_.end(), defaultValue);
+    }
+
+private:
+    mutable std::vector<ValueT> values_;
+    std::vector<uint64_t> words_;
+};
+
+/// arrays in the file mapped with MAP_SHARED: startup doesn't touch the arrays, pages are
+/// loaded and kept by the page cache of OS and content survives restart of the process.
+/// Slots of the new file are zeros, values of absent slots are never read.
+/// The file can be used by one container at a time.
+template<typename ValueT>
+class MappedFileStorage{
+    static_assert(std::is_trivially_copyable<ValueT>::value && alignof(ValueT) <= 64,
+                  "MappedFileStorage: value has to be trivially copyable");
+
+    static constexpr size_t VALUES_ALIGN = 64;
+
+public:
+    explicit MappedFileStorage(std::string path):
+        path_(std::move(path)), words_(nullptr), values_(nullptr)
+    {}
+
+    MappedFileStorage(MappedFileStorage &&) = default;
+    MappedFileStorage &operator=(MappedFileStorage &&) = default;
+
+    bool open(
+            size_t slots,
+            uint64_t layout,
+            const ValueT &)
+    {
+        size_t wordsSize = st_suffix_tree_impl::PresenceBitmap::wordsCount(slots)*sizeof(uint64_t);
+        size_t valuesOffset = (st_suffix_tree_impl::GRID_HEADER_SIZE + wordsSize + VALUES_ALIGN - 1) & ~(VALUES_ALIGN - 1);
+        bool restored = file_.open(
+                path_,
+                st_suffix_tree_impl::makeGridFileHeader(sizeof(ValueT), slots, layout),
+                valuesOffset + slots*sizeof(ValueT));
+        words_ = reinterpret_cast<uint64_t *>(file_.data() + st_suffix_tree_impl::GRID_HEADER_SIZE);
+        values_ = reinterpret_cast<ValueT *>(file_.data() + valuesOffset);
+        return restored;
+    }
+
+    ValueT *values()const noexcept{return values_;}
+    uint64_t *words()noexcept{return words_;}
+
+    void touch(size_t)noexcept
+    {}
+
+    void clearValues(const ValueT &)
+    {}
+
+    void sync()const
+    {
+        file_.sync();
+    }
+
+    const std::string &path()const noexcept{return path_;}
+
+private:
+    std::string path_;
+    st_suffix_tree_impl::GridFile file_;
+    uint64_t *words_;
+    ValueT *values_;
+};
+
+/// arrays in address space reserved by ReservedMemory for sparse grids: default value has to be
+/// zero bytes, pages of absent slots are never committed. Touched pages are tracked, clearValues()
+/// returns only them to OS.
+template<typename ValueT>
+class ReservedStorage{
+    static_assert(std::is_trivially_copyable<ValueT>::value && alignof(ValueT) <= 64,
+                  "ReservedStorage: value has to be trivially copyable");
+
+public:
+    ReservedStorage():
+        words_(nullptr), values_(nullptr), valuesOffset_(0), pageShift_(0)
+    {}
+
+    ReservedStorage(ReservedStorage &&) = default;
+    ReservedStorage &operator=(ReservedStorage &&) = default;
+
+    bool open(
+            size_t slots,
+            uint64_t,
+            const ValueT &defaultValue)
+    {
+        static const char zeros[sizeof(ValueT)] = {};
+        if(0 != std::memcmp(&defaultValue, zeros, sizeof(ValueT)))
+            throw std::runtime_error("ReservedStorage::open: default value has to be zero bytes");
+        size_t pageSize = st_suffix_tree_impl::ReservedMemory::pageSize();
+        size_t wordsSize = st_suffix_tree_impl::PresenceBitmap::wordsCount(slots)*sizeof(uint64_t);
+        valuesOffset_ = (wordsSize + pageSize - 1) & ~(pageSize - 1);
+        memory_.reserve(valuesOffset_ + slots*sizeof(ValueT));
+        pageShift_ = __builtin_ctzll(pageSize);
+        touched_.assign((memory_.size() + pageSize - 1) >> pageShift_);
+        words_ = reinterpret_cast<uint64_t *>(memory_.data());
+        values_ = reinterpret_cast<ValueT *>(memory_.data() + valuesOffset_);
+        return false;
+    }
+
+    ValueT *values()const noexcept{return values_;}
+    uint64_t *words()noexcept{return words_;}
+
+    void touch(size_t index)noexcept
+    {
+        touched_.set((index / 64 * sizeof(uint64_t)) >> pageShift_);
+        touched_.set((valuesOffset_ + index*sizeof(ValueT)) >> pageShift_);
+        touched_.set((valuesOffset_ + (index + 1)*sizeof(ValueT) - 1) >> pageShift_);
+    }
+
+    void clearValues(const ValueT &)
+    {
+        size_t page = touched_.first();
+        while(st_suffix_tree_impl::PresenceBitmap::NPOS != page){
+            size_t last = page;
+            size_t next = touched_.next(last);
+            for(; next == last + 1; next = touched_.next(last))
+                last = next;
+            memory_.release(page << pageShift_, (last - page + 1) << pageShift_);
+            page = next;
+        }
+        touched_.clear();
+    }
+
+    /// bytes of reserved address space
+    size_t reserved()const noexcept{return memory_.size();}
+
+    /// bytes of touched pages, upper bound of committed memory
+    size_t committed()const noexcept{return touched_.count() << pageShift_;}
+
+private:
+    st_suffix_tree_impl::ReservedMemory memory_;
+    /// one bit per page of memory_
+    st_suffix_tree_impl::PresenceBitmap touched_;
+    uint64_t *words_;
+    ValueT *values_;
+    size_t valuesOffset_;
+    size_t pageShift_;
+};
+
+}
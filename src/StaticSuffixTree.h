@@ -1,15 +1,26 @@
 #pragma once
 
 #include <vector>
+#include <array>
 #include <limits>
 #include <algorithm>
 #include <functional>
+#include <string>
+#include <type_traits>
+
+#include "PresenceBitmap.h"
+#include "StaticStorage.h"
+#include "TreeSnapshot.h"
+#include "HashUtils.h"
 
 namespace st_suffix_tree{
 
 namespace st_suffix_tree_impl{
     typedef size_t IndexT;
     const IndexT INVALID_INDEX = std::numeric_limits<size_t>::max();
+    static_assert(INVALID_INDEX == PresenceBitmap::NPOS);
+    /// index of the level of slice pattern, which matches any subkey
+    const IndexT ANY_INDEX = INVALID_INDEX - 1;
 }
 
 template<typename ContT>
@@ -71,7 +82,7 @@ public:
 
     SuffixTreeIterator& operator++() 
     {
-        next();
+        *this = next();
         return *this;
     }
 
@@ -100,55 +111,84 @@ private:
     st_suffix_tree_impl::IndexT index_;
 };
 
-template<typename ContBuilderT, typename KeyT, typename ContValueT>
+/// Dense container: every combination of subkeys has its own slot, index of the slot
+/// is a mixed radix number of subkey indexes. Any builder with SuffixLevel enum
+/// (root_Suffix .. leaf_Suffix), suffixCount(), parseKey(), isValid() and defaultValue()
+/// can be used: StaticContBuilder or SuffixTreeTraits with 2..7 levels.
+/// FixedSuffixTree<Dims<...>, ValueT> with compile time dimensions is defined in FixedSuffixTree.h
+/// StorageT keeps values and words of the presence bitmap (see StaticStorage.h), content of
+/// the storage restored by open() is used as is.
+template<typename ContBuilderT, typename KeyT, typename ContValueT, typename StorageT = VectorStorage<ContValueT>>
 class StaticSuffixTree
 {
 public:
     typedef ContBuilderT BuilderT;
+    typedef typename BuilderT::KeyViewT KeyViewT;
+    typedef typename BuilderT::ParsedKeyT ParsedKeyT;
+    typedef typename BuilderT::SuffixLevel SuffixLevel;
     typedef ContValueT ValueT;
-    typedef StaticSuffixTree<ContBuilderT, KeyT, ContValueT> ThisTypeT;
+    typedef StorageT StorageTypeT;
+    typedef StaticSuffixTree<ContBuilderT, KeyT, ContValueT, StorageT> ThisTypeT;
     typedef SuffixTreeIterator<ThisTypeT> Iterator;
 
+    static constexpr size_t LEVELS_COUNT = SuffixLevel::leaf_Suffix + 1;
+
     friend Iterator;
+
+private:
+    typedef std::array<size_t, LEVELS_COUNT> StridesT;
+
 public:
     StaticSuffixTree(
-            const BuilderT &builder):
-        builder_(builder), size_(0)
+            const BuilderT &builder,
+            StorageT storage = StorageT()):
+        builder_(builder), storage_(std::move(storage)), size_(0)
     {
         size_t totalSize = 1;
-        for(size_t lvl = BuilderT::root_Suffix; lvl <= BuilderT::leaf_Suffix; ++lvl)
+        for(size_t lvl = LEVELS_COUNT; lvl-- > SuffixLevel::root_Suffix;)
         {
-            totalSize *= builder.suffixCount(static_cast<typename BuilderT::SuffixLevel>(lvl));
+            strides_[lvl] = totalSize;
+            totalSize *= builder.suffixCount(static_cast<SuffixLevel>(lvl));
         }
-        optional_.assign(totalSize, 0);
-        values_.assign(totalSize, BuilderT::defaultValue());
+        storage_.open(totalSize, layoutHash(), BuilderT::defaultValue());
+        optional_.attach(storage_.words(), totalSize);
+        size_ = optional_.count();
     }
 
-    ~StaticSuffixTree()
+    /// compiles only with copyable StorageT, e.g. VectorStorage
+    StaticSuffixTree(
+            const StaticSuffixTree &sft):
+        builder_(sft.builder_), strides_(sft.strides_), storage_(sft.storage_), size_(sft.size_)
     {
-        clear();
+        static_assert(std::is_copy_constructible<StorageT>::value, "StaticSuffixTree: StorageT is not copyable");
+        optional_.attach(storage_.words(), sft.optional_.size());
     }
 
+    /// presence bitmap is attached to the words of the moved storage, sft is left empty
     StaticSuffixTree(
-            const StaticSuffixTree &sft):
-        builder_(sft.builder_), values_(sft.values_), optional_(sft.optional_), size_(sft.size_)
-    {}
+            StaticSuffixTree &&sft):
+        builder_(std::move(sft.builder_)), strides_(sft.strides_), storage_(std::move(sft.storage_)), size_(sft.size_)
+    {
+        optional_.attach(storage_.words(), sft.optional_.size());
+        sft.optional_ = st_suffix_tree_impl::PresenceBitmap();
+        sft.size_ = 0;
+    }
 
+    /// copy or move assignment, depends on the constructor of sft
     StaticSuffixTree &operator=(
-            const StaticSuffixTree sft)
+            StaticSuffixTree sft)
     {
         std::swap(builder_, sft.builder_);
-        std::swap(values_, sft.values_);
-        optional_ = sft.optional_;
-        size_ = sft.size_;
+        std::swap(strides_, sft.strides_);
+        std::swap(storage_, sft.storage_);
+        optional_.swap(sft.optional_);
+        std::swap(size_, sft.size_);
+        return *this;
     }
 
     Iterator begin()const
     {
-        for(size_t i = 0; i < optional_.size(); ++i)
-            if(optional_[i])
-                return Iterator(this, i);
-        return end();
+        return Iterator(this, optional_.first());
     }
 
     Iterator end()const
@@ -157,54 +197,84 @@ public:
     }
 
     Iterator insert(
-            const KeyT &key, 
+            const char *key,
+            size_t length,
             const ValueT &val)
     {
-        typename ContBuilderT::ParsedKeyT parsedKey;
+        return insert(KeyViewT(key, length), val);
+    }
+
+    Iterator insert(
+            KeyViewT key,
+            const ValueT &val)
+    {
+        ParsedKeyT parsedKey;
         if(!builder_.parseKey(key, parsedKey))
             return end();
+        return insertParsed(parsedKey, val);
+    }
 
-        size_t index = calcIndex(parsedKey);
-        values_[index] = val;
-        if(!optional_[index])
-            ++size_;
-        optional_[index] = true;
-        return Iterator(this, index);
+    /// inserts value by key parsed with builder()
+    Iterator insert(
+            const ParsedKeyT &parsedKey,
+            const ValueT &val)
+    {
+        if(!builder_.isValid(parsedKey))
+            return end();
+        return insertParsed(parsedKey, val);
     }
 
-    Iterator find(const KeyT &key)const
+    Iterator find(
+            const char *key,
+            size_t length)const
     {
-        typename ContBuilderT::ParsedKeyT parsedKey;
+        return find(KeyViewT(key, length));
+    }
+
+    Iterator find(KeyViewT key)const
+    {
+        ParsedKeyT parsedKey;
         if(!builder_.parseKey(key, parsedKey))
             return end();
-        size_t index = calcIndex(parsedKey);
-        if(optional_[index])
-            return Iterator(this, index);
-        return end();
+        return findParsed(parsedKey);
+    }
+
+    Iterator find(const ParsedKeyT &parsedKey)const
+    {
+        if(!builder_.isValid(parsedKey))
+            return end();
+        return findParsed(parsedKey);
     }
 
-    Iterator erase(const KeyT &key)
+    Iterator erase(
+            const char *key,
+            size_t length)
     {
-        typename ContBuilderT::ParsedKeyT parsedKey;
+        return erase(KeyViewT(key, length));
+    }
+
+    Iterator erase(KeyViewT key)
+    {
+        ParsedKeyT parsedKey;
         if(!builder_.parseKey(key, parsedKey))
             return end();
-        size_t index = calcIndex(parsedKey);
-        if(!optional_[index])
+        return eraseParsed(parsedKey);
+    }
+
+    Iterator erase(const ParsedKeyT &parsedKey)
+    {
+        if(!builder_.isValid(parsedKey))
             return end();
-        optional_[index] = false;
-        --size_;
-        return next(index);
+        return eraseParsed(parsedKey);
     }
 
     Iterator erase(const Iterator &it)
     {
         if(end() == it)
             return end();
-        Iterator nextIt = it.next();
         size_t index = it.index();
-        if(optional_[index]){
+        if(optional_.reset(index)){
             --size_;
-            optional_[index] = false;
             return next(index);
         }
         return end();
@@ -212,47 +282,282 @@ public:
 
     size_t size()const{return size_;}
 
+    /// count of values with keys in [first, last], keys are ordered by indexes of subkeys
+    /// O(log(slots / 4096)) prefix sums of block counts plus popcounts of 2 boundary blocks
+    size_t count(
+            const ParsedKeyT &first,
+            const ParsedKeyT &last)const
+    {
+        if(!builder_.isValid(first) || !builder_.isValid(last))
+            return 0;
+        return optional_.countRange(calcIndex(first), calcIndex(last) + 1);
+    }
+
+    /// calls func(const ParsedKeyT &key, const ValueT &val) for values with keys matching pattern
+    /// in order of indexes, levels of pattern are subkey indexes or ANY_INDEX, so any subset of levels
+    /// can be fixed. Trailing ANY_INDEX levels are scanned as contiguous ranges of the presence bitmap,
+    /// otherwise the innermost free level is scanned with stride by 64 bits at once.
+    /// Returns count of visited values
+    template<typename FuncT>
+    size_t slice(
+            const ParsedKeyT &pattern,
+            FuncT &&func)const
+    {
+        using st_suffix_tree_impl::ANY_INDEX;
+        if(0 == optional_.size())
+            return 0;
+        ParsedKeyT key;
+        for(size_t lvl = 0; lvl < LEVELS_COUNT; ++lvl){
+            if(ANY_INDEX != pattern[lvl] && pattern[lvl] >= builder_.suffixCount(static_cast<SuffixLevel>(lvl)))
+                return 0;
+            key[lvl] = ANY_INDEX == pattern[lvl]? 0: pattern[lvl];
+        }
+        /// levels from tail are free and form contiguous range, otherwise inner is the strided level
+        size_t tail = LEVELS_COUNT;
+        while(0 != tail && ANY_INDEX == pattern[tail - 1])
+            --tail;
+        size_t inner = LEVELS_COUNT;
+        if(LEVELS_COUNT == tail){
+            for(size_t lvl = LEVELS_COUNT; LEVELS_COUNT == inner && lvl-- > 0;){
+                if(ANY_INDEX == pattern[lvl])
+                    inner = lvl;
+            }
+        }
+        size_t outer = LEVELS_COUNT == tail? inner: tail;
+
+        size_t visited = 0;
+        for(bool more = true; more;){
+            size_t base = calcIndex(key);
+            if(LEVELS_COUNT != tail)
+                visited += sliceRange(base, 0 == tail? optional_.size(): base + strides_[tail - 1], tail, key, func);
+            else if(LEVELS_COUNT != inner)
+                visited += sliceStrided(base, inner, key, func);
+            else if(optional_.test(base)){
+                func(key, storage_.values()[base]);
+                ++visited;
+            }
+            /// next combination of free levels before outer
+            more = false;
+            for(size_t lvl = outer; !more && lvl-- > 0;){
+                if(ANY_INDEX != pattern[lvl])
+                    continue;
+                more = ++key[lvl] < builder_.suffixCount(static_cast<SuffixLevel>(lvl));
+                if(!more)
+                    key[lvl] = 0;
+            }
+        }
+        return visited;
+    }
+
+    /// appends values with keys matching pattern (see slice()) to res, returns count of them
+    size_t gather(
+            const ParsedKeyT &pattern,
+            std::vector<ValueT> &res)const
+    {
+        return slice(pattern, [&res](const ParsedKeyT &, const ValueT &val){res.push_back(val);});
+    }
+
+    /// builder, which has to be used to parse keys for the ParsedKeyT based methods
+    const BuilderT &builder()const noexcept{return builder_;}
+
+    const StorageT &storage()const noexcept{return storage_;}
+
     void clear()
     {
         size_ = 0;
-        size_t s = optional_.size();
-        optional_.assign(s, 0);
-        values_.assign(s, BuilderT::defaultValue());
+        optional_.clear();
+        storage_.clearValues(BuilderT::defaultValue());
+    }
+
+    /// writes binary image (see TreeSnapshot.h): dictionaries, words of presence bitmap and values
+    void save(const std::string &path)const
+    {
+        static_assert(std::is_trivially_copyable<ValueT>::value && alignof(ValueT) <= 8,
+                      "StaticSuffixTree::save: value has to be trivially copyable");
+        aux::SnapshotWriter writer(path);
+        aux::SnapshotHeader header = aux::makeSnapshotHeader(
+                aux::static_SnapshotKind, LEVELS_COUNT, sizeof(ValueT), size_, builder_.delimeter());
+        for(size_t level = 0; level < LEVELS_COUNT; ++level){
+            uint64_t offset = writer.writeDictionary(builder_.subkeys(level));
+            if(0 == level)
+                header.dictionaries_ = offset;
+        }
+        header.data_ = writer.offset();
+        writer.writeValue(static_cast<uint64_t>(optional_.size()));
+        writer.writeValue(static_cast<uint64_t>(optional_.wordsSize()));
+        writer.write(optional_.words(), optional_.wordsSize()*sizeof(uint64_t));
+        writer.align();
+        writer.write(storage_.values(), optional_.size()*sizeof(ValueT));
+        writer.finish(header);
+    }
+
+    /// replaces content by the image written by save(), dictionaries of the image have to be
+    /// the same as dictionaries of builder(). Present values are copied from the mapped file
+    void load(const std::string &path)
+    {
+        static_assert(std::is_trivially_copyable<ValueT>::value && alignof(ValueT) <= 8,
+                      "StaticSuffixTree::load: value has to be trivially copyable");
+        aux::MappedFile file(path);
+        const aux::SnapshotHeader &header = aux::checkSnapshotHeader(
+                file, aux::static_SnapshotKind, LEVELS_COUNT, sizeof(ValueT));
+        auto dictionaries = aux::readSnapshotDictionaries(file, header);
+        for(size_t level = 0; level < LEVELS_COUNT; ++level){
+            auto subkeys = builder_.subkeys(level);
+            bool same = subkeys.size() == dictionaries[level].size();
+            for(size_t i = 0; same && i < subkeys.size(); ++i)
+                same = subkeys[i] == dictionaries[level].key(i);
+            if(!same)
+                throw std::runtime_error("StaticSuffixTree::load: dictionaries of snapshot differ from builder");
+        }
+
+        const uint64_t *counts = file.at<uint64_t>(header.data_, 2);
+        if(nullptr == counts || optional_.size() != counts[0])
+            throw std::runtime_error("StaticSuffixTree::load: snapshot is corrupted");
+        uint64_t wordsOffset = header.data_ + 2*sizeof(uint64_t);
+        const uint64_t *words = file.at<uint64_t>(wordsOffset, counts[1]);
+        const ValueT *values = file.at<ValueT>(
+                (wordsOffset + counts[1]*sizeof(uint64_t) + 7) & ~uint64_t(7), counts[0]);
+        if(nullptr == words || nullptr == values || optional_.wordsSize() != counts[1])
+            throw std::runtime_error("StaticSuffixTree::load: snapshot is corrupted");
+        clear();
+        for(size_t i = 0; i < counts[1]; ++i){
+            for(uint64_t bits = words[i]; 0 != bits; bits &= bits - 1){
+                size_t index = i*64 + __builtin_ctzll(bits);
+                if(index < counts[0])
+                    insertAt(index, values[index]);
+            }
+        }
     }
 
 private:
+    Iterator insertParsed(
+            const ParsedKeyT &parsedKey,
+            const ValueT &val)
+    {
+        size_t index = calcIndex(parsedKey);
+        insertAt(index, val);
+        return Iterator(this, index);
+    }
 
-    Iterator next(st_suffix_tree_impl::IndexT index)const
+    void insertAt(
+            st_suffix_tree_impl::IndexT index,
+            const ValueT &val)
     {
-        for(size_t i = index + 1; i < optional_.size(); ++i)
-            if(optional_[i])
-                return Iterator(this, i);
+        storage_.touch(index);
+        storage_.values()[index] = val;
+        if(optional_.set(index))
+            ++size_;
+    }
+
+    Iterator findParsed(const ParsedKeyT &parsedKey)const
+    {
+        size_t index = calcIndex(parsedKey);
+        if(optional_.test(index))
+            return Iterator(this, index);
         return end();
     }
 
+    Iterator eraseParsed(const ParsedKeyT &parsedKey)
+    {
+        size_t index = calcIndex(parsedKey);
+        if(!optional_.reset(index))
+            return end();
+        --size_;
+        return next(index);
+    }
+
+    /// visits present slots in [first, last), levels from tail of key are restored from index
+    template<typename FuncT>
+    size_t sliceRange(
+            size_t first,
+            size_t last,
+            size_t tail,
+            ParsedKeyT &key,
+            FuncT &func)const
+    {
+        size_t visited = 0;
+        size_t index = optional_.test(first)? first: optional_.next(first);
+        for(; index < last; index = optional_.next(index)){
+            size_t offset = index - first;
+            for(size_t lvl = LEVELS_COUNT; lvl-- > tail;){
+                size_t count = builder_.suffixCount(static_cast<SuffixLevel>(lvl));
+                key[lvl] = offset % count;
+                offset /= count;
+            }
+            func(key, storage_.values()[index]);
+            ++visited;
+        }
+        for(size_t lvl = tail; lvl < LEVELS_COUNT; ++lvl)
+            key[lvl] = 0;
+        return visited;
+    }
+
+    /// visits present slots base + i*strides_[inner] for every subkey i of the inner level
+    template<typename FuncT>
+    size_t sliceStrided(
+            size_t base,
+            size_t inner,
+            ParsedKeyT &key,
+            FuncT &func)const
+    {
+        const size_t stride = strides_[inner];
+        const size_t count = builder_.suffixCount(static_cast<SuffixLevel>(inner));
+        size_t visited = 0;
+        for(size_t chunk = 0; chunk < count; chunk += 64){
+            uint64_t mask = optional_.testStrided(base + chunk*stride, stride, std::min<size_t>(64, count - chunk));
+            for(; 0 != mask; mask &= mask - 1){
+                size_t subkey = chunk + __builtin_ctzll(mask);
+                key[inner] = subkey;
+                func(key, storage_.values()[base + subkey*stride]);
+                ++visited;
+            }
+        }
+        key[inner] = 0;
+        return visited;
+    }
+
+    Iterator next(st_suffix_tree_impl::IndexT index)const
+    {
+        return Iterator(this, optional_.next(index));
+    }
+
 
     ValueT &get(
             st_suffix_tree_impl::IndexT index)const
     {
-        if(!optional_[index])
+        if(!optional_.test(index))
             throw std::runtime_error("StaticSuffixTree::get: element is not exist at index");
-        return values_[index];
+        return storage_.values()[index];
     }
 
-    size_t calcIndex(const typename ContBuilderT::ParsedKeyT &key)const
+    /// hash of dictionaries of all levels, storage restores content only for the same layout
+    uint64_t layoutHash()const
     {
-        size_t index = key[BuilderT::root_Suffix];
-        for(size_t lvl = BuilderT::root_Suffix + 1; lvl <= BuilderT::leaf_Suffix; ++lvl)
-        {
-            index = index*builder_.suffixCount(static_cast<typename BuilderT::SuffixLevel>(lvl)) + key[lvl];
+        uint64_t hash = 0;
+        for(size_t level = 0; level < LEVELS_COUNT; ++level){
+            auto subkeys = builder_.subkeys(level);
+            hash = aux::hashMix(hash ^ subkeys.size(), aux::HASH_PRIME_1);
+            for(auto &subkey: subkeys)
+                hash = aux::hashBytes(subkey.data(), subkey.length(), hash);
         }
+        return hash;
+    }
+
+    size_t calcIndex(const ParsedKeyT &key)const noexcept
+    {
+        size_t index = 0;
+        for(size_t lvl = SuffixLevel::root_Suffix; lvl < LEVELS_COUNT; ++lvl)
+            index += key[lvl]*strides_[lvl];
         return index;
     }
 
 private:
     BuilderT builder_;
-    mutable std::vector<ValueT> values_;
-    std::vector<bool> optional_;
+    /// strides_[lvl] is product of suffix counts of levels below lvl
+    StridesT strides_;
+    StorageT storage_;
+    /// words are in storage_
+    st_suffix_tree_impl::PresenceBitmap optional_;
     size_t size_;
 };
 
@@ -5,8 +5,17 @@
 
 #include <memory>
 #include <functional>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <system_error>
+#include <string>
 
 #include "SuffixTreeImpl.h"
+#include "TreeSnapshot.h"
 
 namespace suffix_tree{
 
@@ -63,24 +72,14 @@ namespace suffix_tree{
 
         SuffixTreeIterator next()const
         {
-            if(nullptr == node_ || suffix_tree_impl::INVALID_INDEX == index_)
-                return SuffixTreeIterator();
-            size_t nextIdx = node_->next(index_);
-            if(suffix_tree_impl::INVALID_INDEX != nextIdx)
-                return SuffixTreeIterator(node_, nextIdx);
-
-            auto *prntNode = node_->parent();
-            if(nullptr == prntNode)
-                return SuffixTreeIterator();
-            auto * nextNode = prntNode->nextNode(node_);
-            if(nullptr == nextNode)
-                return SuffixTreeIterator();
-            return SuffixTreeIterator(nextNode, nextNode->begin());
+            SuffixTreeIterator it(*this);
+            it.advance();
+            return it;
         }
 
         SuffixTreeIterator& operator++()
         {
-            next();
+            advance();
             return *this;
         }
 
@@ -105,6 +104,38 @@ namespace suffix_tree{
 
         size_t index()const noexcept{return index_;}
 
+    private:
+        /// moves to the next value in the same leaf or to the first value of the next leaf
+        void advance()noexcept
+        {
+            if(nullptr == node_ || suffix_tree_impl::INVALID_INDEX == index_){
+                reset();
+                return;
+            }
+            size_t nextIdx = node_->next(index_);
+            if(suffix_tree_impl::INVALID_INDEX != nextIdx){
+                index_ = nextIdx;
+                return;
+            }
+
+            auto *prntNode = node_->parent();
+            const LeafNodeT *nextNode = (nullptr != prntNode)? prntNode->nextNode(node_): nullptr;
+            if(nullptr == nextNode){
+                reset();
+                return;
+            }
+            node_ = nextNode;
+            index_ = nextNode->begin();
+            if(suffix_tree_impl::INVALID_INDEX == index_)
+                node_ = nullptr;
+        }
+
+        void reset()noexcept
+        {
+            node_ = nullptr;
+            index_ = suffix_tree_impl::INVALID_INDEX;
+        }
+
     private:
         const LeafNodeT *node_;
         size_t index_;
@@ -116,6 +147,8 @@ namespace suffix_tree{
     public:
         typedef ContTraitsT TraitsT;
         typedef typename TraitsT::KeyT KeyT;
+        typedef typename TraitsT::KeyViewT KeyViewT;
+        typedef typename TraitsT::ParsedKeyT ParsedKeyT;
         typedef typename TraitsT::ValueT ValueT;
         typedef SuffixTree<ContTraitsT> ThisTypeT;
         typedef SuffixTreeIterator<ThisTypeT> Iterator;
@@ -124,13 +157,21 @@ namespace suffix_tree{
         typedef std::function<Iterator(const LeafNodeT *node)> CNodeFunctorT;
         typedef suffix_tree_impl::RootNode<TraitsT> RootNodeT;
         typedef std::unique_ptr<RootNodeT> RootNodePtrT;
+        typedef typename RootNodeT::AllocatorT AllocatorT;
+        typedef std::remove_pointer_t<decltype(std::declval<RootNodeT>().findChild(0))> SubtreeNodeT;
+
+        /// count of keys, which are walked through the tree together by batch methods
+        static constexpr size_t BATCH_GROUP_SIZE = 16;
+        /// bulk_insert() doesn't start more threads than count of keys divided by this value
+        static constexpr size_t BULK_MIN_KEYS_PER_THREAD = 4096;
 
     public:
         explicit SuffixTree(
                 const TraitsT &traits):
                 traits_(traits),
-                root_(new RootNodeT(traits_)),
-                size_(0)
+                root_(new RootNodeT(allocator_, traits_)),
+                size_(0),
+                teardownThreads_(1)
         {
         }
 
@@ -142,16 +183,54 @@ namespace suffix_tree{
         SuffixTree(
                 const SuffixTree &sft):
                 traits_(sft.traits_),
-                root_(new RootNodeT(*sft.root_, traits_)),
-                size_(sft.size_)
+                root_(new RootNodeT(*sft.root_, allocator_, traits_)),
+                size_(sft.size_),
+                teardownThreads_(sft.teardownThreads_)
         {}
 
+        /// copies subtrees of root subkeys by threadsCount threads, every thread uses its own pools,
+        /// which are adopted by the tree allocator at the end
+        SuffixTree(
+                const SuffixTree &sft,
+                size_t threadsCount):
+                traits_(sft.traits_),
+                root_(new RootNodeT(allocator_, traits_)),
+                size_(sft.size_),
+                teardownThreads_(sft.teardownThreads_)
+        {
+            std::vector<const SubtreeNodeT *> sources = sft.subtrees();
+            std::vector<SubtreeNodeT *> subtrees(sources.size(), nullptr);
+            threadsCount = std::max<size_t>(1, std::min(threadsCount, sources.size()));
+            std::vector<std::unique_ptr<AllocatorT>> pools(threadsCount);
+            for(auto &pool: pools)
+                pool.reset(new AllocatorT());
+            std::vector<std::exception_ptr> errors(threadsCount);
+            runParallel(threadsCount, sources.size(), [&](size_t part, size_t from, size_t to)
+            {
+                try{
+                    for(size_t i = from; i < to; ++i){
+                        subtrees[i] = createCopy(sources[i], root_.get(), *pools[part]);
+                        copyChildren(sources[i], subtrees[i], *pools[part]);
+                    }
+                }catch(...){
+                    errors[part] = std::current_exception();
+                }
+            });
+            linkSubtrees(pools, errors, subtrees);
+        }
+
         SuffixTree &operator=(
-                SuffixTree sft)
+                const SuffixTree &sft)
         {
-            std::swap(traits_, sft.traits_);
-            root_ = sft.root_;
+            if(this == &sft)
+                return *this;
+            clear();
+            root_.reset();
+            traits_ = sft.traits_;
+            root_.reset(new RootNodeT(*sft.root_, allocator_, traits_));
             size_ = sft.size_;
+            teardownThreads_ = sft.teardownThreads_;
+            return *this;
         }
 
         Iterator begin()const
@@ -173,29 +252,50 @@ namespace suffix_tree{
         }
 
         Iterator insert(
-                const KeyT &key,
+                const char *key,
+                size_t length,
+                const ValueT &val)
+        {
+            return insert(KeyViewT(key, length), val);
+        }
+
+        Iterator insert(
+                KeyViewT key,
                 const ValueT &val)
         {
-            typename ContTraitsT::ParsedKeyT parsedKey;
+            ParsedKeyT parsedKey;
             if(!traits_.parseNewKey(key, parsedKey))
                 return end();
-            size_t index = 0;
-            size_t leafIndex = parsedKey[ContTraitsT::SuffixLevel::leaf_Suffix];
-            auto insertFunc = [&, this](LeafNodeT *node)->ThisTypeT::Iterator
-            {
-                if(node->set(leafIndex, val))
-                    ++size_;
-                return ThisTypeT::Iterator(node, leafIndex);
-            };
+            return insertParsed(parsedKey, val);
+        }
 
-            return applyFunc(root_.get(), parsedKey, index, insertFunc);
+        /// inserts value by key parsed with traits(), subkeys unknown to traits() are rejected
+        Iterator insert(
+                const ParsedKeyT &parsedKey,
+                const ValueT &val)
+        {
+            if(!traits_.isValid(parsedKey))
+                return end();
+            return insertParsed(parsedKey, val);
+        }
+
+        Iterator find(
+                const char *key,
+                size_t length)const
+        {
+            return find(KeyViewT(key, length));
         }
 
-        Iterator find(const KeyT &key)const
+        Iterator find(KeyViewT key)const
         {
-            typename ContTraitsT::ParsedKeyT parsedKey;
+            ParsedKeyT parsedKey;
             if(!traits_.parseKey(key, parsedKey))
                 return end();
+            return find(parsedKey);
+        }
+
+        Iterator find(const ParsedKeyT &parsedKey)const
+        {
             size_t index = 0;
             size_t leafIndex = parsedKey[ContTraitsT::SuffixLevel::leaf_Suffix];
             auto findFunc = [&, this](LeafNodeT *node)->ThisTypeT::Iterator
@@ -205,24 +305,39 @@ namespace suffix_tree{
                 return ThisTypeT::Iterator(node, leafIndex);
             };
 
-            return applyFunc(root_.get(), parsedKey, index, findFunc);
+            return lookupFunc(root_.get(), parsedKey, index, findFunc);
         }
 
-        Iterator erase(const KeyT &key)
+        Iterator erase(
+                const char *key,
+                size_t length)
         {
-            typename ContTraitsT::ParsedKeyT parsedKey;
+            return erase(KeyViewT(key, length));
+        }
+
+        Iterator erase(KeyViewT key)
+        {
+            ParsedKeyT parsedKey;
             if(!traits_.parseKey(key, parsedKey))
                 return end();
+            return erase(parsedKey);
+        }
+
+        Iterator erase(const ParsedKeyT &parsedKey)
+        {
             size_t index = 0;
             size_t leafIndex = parsedKey[ContTraitsT::SuffixLevel::leaf_Suffix];
             auto eraseFunc = [&, this](LeafNodeT *node)->ThisTypeT::Iterator
             {
+                if(!node->exist(leafIndex))
+                    return end();
                 auto nextIt = ThisTypeT::Iterator(node, leafIndex).next();
                 if(node->erase(leafIndex))
                     --size_;
+                prune(node);
                 return nextIt;
             };
-            return applyFunc(root_.get(), parsedKey, index, eraseFunc);
+            return lookupFunc(root_.get(), parsedKey, index, eraseFunc);
         }
 
         Iterator erase(const Iterator &it)
@@ -230,20 +345,262 @@ namespace suffix_tree{
             if(end() == it)
                 return end();
             Iterator nextIt = it.next();
-            if(const_cast<typename Iterator::LeafNodeT *>(it.node())->erase(it.index()))
+            auto *node = const_cast<typename Iterator::LeafNodeT *>(it.node());
+            if(node->erase(it.index())){
                 --size_;
+                prune(node);
+            }
             return nextIt;
         }
 
+        /// finds count keys, results[i] is iterator to keys[i] or end().
+        /// Keys are processed in groups: every level of the tree is resolved for the whole group
+        /// with prefetch of memory, which is needed for the next level
+        void find_batch(
+                const KeyViewT *keys,
+                size_t count,
+                Iterator *results)const
+        {
+            ParsedKeyT parsedKeys[BATCH_GROUP_SIZE];
+            RootNodeT *nodes[BATCH_GROUP_SIZE];
+            for(size_t start = 0; start < count; start += BATCH_GROUP_SIZE){
+                size_t groupSize = std::min(BATCH_GROUP_SIZE, count - start);
+                for(size_t i = 0; i < groupSize; ++i){
+                    nodes[i] = traits_.parseKey(keys[start + i], parsedKeys[i])? root_.get(): nullptr;
+                    if(nullptr != nodes[i])
+                        nodes[i]->prefetchChild(parsedKeys[i][0]);
+                }
+                findBatch(nodes, parsedKeys, 0, groupSize, results + start);
+            }
+        }
+
+        void find_batch(
+                const ParsedKeyT *keys,
+                size_t count,
+                Iterator *results)const
+        {
+            RootNodeT *nodes[BATCH_GROUP_SIZE];
+            for(size_t start = 0; start < count; start += BATCH_GROUP_SIZE){
+                size_t groupSize = std::min(BATCH_GROUP_SIZE, count - start);
+                for(size_t i = 0; i < groupSize; ++i){
+                    nodes[i] = root_.get();
+                    nodes[i]->prefetchChild(keys[start + i][0]);
+                }
+                findBatch(nodes, keys + start, 0, groupSize, results + start);
+            }
+        }
+
+        /// inserts values[i] by keys[i], results[i] is iterator to inserted value or end()
+        void insert_batch(
+                const KeyViewT *keys,
+                const ValueT *values,
+                size_t count,
+                Iterator *results)
+        {
+            ParsedKeyT parsedKeys[BATCH_GROUP_SIZE];
+            RootNodeT *nodes[BATCH_GROUP_SIZE];
+            for(size_t start = 0; start < count; start += BATCH_GROUP_SIZE){
+                size_t groupSize = std::min(BATCH_GROUP_SIZE, count - start);
+                for(size_t i = 0; i < groupSize; ++i){
+                    nodes[i] = traits_.parseNewKey(keys[start + i], parsedKeys[i])? root_.get(): nullptr;
+                    if(nullptr != nodes[i])
+                        nodes[i]->prefetchChild(parsedKeys[i][0]);
+                }
+                insertBatch(nodes, parsedKeys, 0, groupSize, values + start, results + start);
+            }
+        }
+
+        void insert_batch(
+                const ParsedKeyT *keys,
+                const ValueT *values,
+                size_t count,
+                Iterator *results)
+        {
+            RootNodeT *nodes[BATCH_GROUP_SIZE];
+            for(size_t start = 0; start < count; start += BATCH_GROUP_SIZE){
+                size_t groupSize = std::min(BATCH_GROUP_SIZE, count - start);
+                for(size_t i = 0; i < groupSize; ++i){
+                    nodes[i] = traits_.isValid(keys[start + i])? root_.get(): nullptr;
+                    if(nullptr != nodes[i])
+                        nodes[i]->prefetchChild(keys[start + i][0]);
+                }
+                insertBatch(nodes, keys + start, 0, groupSize, values + start, results + start);
+            }
+        }
+
+        /// inserts pairs (key, value) of the random access range [first, last), returns count of accepted keys.
+        /// Keys are parsed in parallel against the current dictionaries, new subkeys are added afterwards
+        /// in order of the range, so indexes are the same as with sequential insert(). Parsed keys are
+        /// radix sorted and subtrees of root subkeys, which aren't in the tree yet, are built by worker
+        /// threads in their own pools and linked under the root at the end. For duplicated keys the last
+        /// value wins.
+        template<typename RandomItT>
+        size_t bulk_insert(
+                RandomItT first,
+                RandomItT last,
+                size_t threadsCount = std::thread::hardware_concurrency())
+        {
+            size_t count = static_cast<size_t>(std::distance(first, last));
+            threadsCount = std::max<size_t>(1, std::min(threadsCount, count / BULK_MIN_KEYS_PER_THREAD + 1));
+
+            std::vector<ParsedKeyT> parsedKeys(count);
+            std::vector<char> accepted(count, 0);
+            runParallel(threadsCount, count, [&](size_t, size_t from, size_t to)
+            {
+                for(size_t i = from; i < to; ++i)
+                    accepted[i] = traits_.parseKey(KeyViewT(first[i].first), parsedKeys[i]);
+            });
+            std::vector<size_t> order;
+            order.reserve(count);
+            for(size_t i = 0; i < count; ++i){
+                if(0 == accepted[i] && !traits_.parseNewKey(KeyViewT(first[i].first), parsedKeys[i]))
+                    continue;
+                order.push_back(i);
+            }
+            radixSort(parsedKeys, order);
+
+            typedef std::pair<size_t, size_t> RangeT;
+            std::vector<RangeT> newSubtrees;
+            std::vector<size_t> existing;
+            for(size_t from = 0; from < order.size();){
+                size_t rootIndex = parsedKeys[order[from]][0];
+                size_t to = from + 1;
+                while(to < order.size() && rootIndex == parsedKeys[order[to]][0])
+                    ++to;
+                if(nullptr == root_->findChild(rootIndex))
+                    newSubtrees.emplace_back(from, to);
+                else
+                    existing.insert(std::end(existing), std::begin(order) + from, std::begin(order) + to);
+                from = to;
+            }
+
+            std::vector<SubtreeNodeT *> subtrees(newSubtrees.size(), nullptr);
+            std::vector<size_t> added(newSubtrees.size(), 0);
+            threadsCount = std::max<size_t>(1, std::min(threadsCount, newSubtrees.size()));
+            std::vector<std::unique_ptr<AllocatorT>> pools(threadsCount);
+            for(auto &pool: pools)
+                pool.reset(new AllocatorT());
+            std::vector<std::exception_ptr> errors(threadsCount);
+            std::atomic<size_t> nextSubtree(0);
+            runParallel(threadsCount, threadsCount, [&](size_t worker, size_t, size_t)
+            {
+                try{
+                    for(size_t idx = nextSubtree++; idx < newSubtrees.size(); idx = nextSubtree++){
+                        const size_t *from = order.data() + newSubtrees[idx].first;
+                        const size_t *to = order.data() + newSubtrees[idx].second;
+                        subtrees[idx] = pools[worker]->template allocatorOf<SubtreeNodeT>().create(
+                                allocator_, root_.get(), parsedKeys[*from][0], traits_);
+                        added[idx] = buildSubtree(subtrees[idx], 1, from, to, parsedKeys, first, *pools[worker]);
+                    }
+                }catch(...){
+                    errors[worker] = std::current_exception();
+                }
+            });
+
+            linkSubtrees(pools, errors, subtrees);
+            for(auto val: added)
+                size_ += val;
+
+            for(auto idx: existing)
+                insertParsed(parsedKeys[idx], first[idx].second);
+            return order.size();
+        }
+
         size_t size()const noexcept{return size_;}
 
+        /// traits, which have to be used to parse keys for the ParsedKeyT based methods
+        const TraitsT &traits()const noexcept{return traits_;}
+
         void clear()
+        {
+            clear(teardownThreads_);
+        }
+
+        /// destroys subtrees of root subkeys by threadsCount threads, slots of nodes are not returned
+        /// to the pools one by one, pools release their chunks at once at the end
+        void clear(size_t threadsCount)
         {
             size_ = 0;
-            root_->clear();
+            std::vector<SubtreeNodeT *> nodes;
+            for(auto *node: subtrees())
+                nodes.push_back(const_cast<SubtreeNodeT *>(node));
+            root_->detachChildren();
+            threadsCount = std::max<size_t>(1, std::min(threadsCount, nodes.size()));
+            runParallel(threadsCount, nodes.size(), [&](size_t, size_t from, size_t to)
+            {
+                for(size_t i = from; i < to; ++i)
+                    destroySubtree(nodes[i]);
+            });
+            allocator_.clear();
+        }
+
+        /// writes binary image of the tree (see TreeSnapshot.h), it can be served by MappedSuffixTree
+        /// or loaded by load(). Traits have to provide subkeys(level) and delimeter()
+        void save(const std::string &path)const
+        {
+            static_assert(std::is_trivially_copyable<ValueT>::value && alignof(ValueT) <= 8,
+                          "SuffixTree::save: value has to be trivially copyable");
+            aux::SnapshotWriter writer(path);
+            aux::SnapshotHeader header = aux::makeSnapshotHeader(
+                    aux::tree_SnapshotKind, ContTraitsT::SuffixLevel::total_Suffix, sizeof(ValueT), size_, traits_.delimeter());
+            for(size_t level = 0; level < ContTraitsT::SuffixLevel::total_Suffix; ++level){
+                uint64_t offset = writer.writeDictionary(traits_.subkeys(level));
+                if(0 == level)
+                    header.dictionaries_ = offset;
+            }
+            header.data_ = saveNode(writer, root_.get());
+            writer.finish(header);
+        }
+
+        /// replaces content of the tree by the image written by save(), subkeys of the image are
+        /// added to traits by addSubkey(level, subkey). Nodes are rebuilt from the mapped file
+        /// by indexes, keys are not parsed
+        void load(const std::string &path)
+        {
+            static_assert(std::is_trivially_copyable<ValueT>::value && alignof(ValueT) <= 8,
+                          "SuffixTree::load: value has to be trivially copyable");
+            aux::MappedFile file(path);
+            const aux::SnapshotHeader &header = aux::checkSnapshotHeader(
+                    file, aux::tree_SnapshotKind, ContTraitsT::SuffixLevel::total_Suffix, sizeof(ValueT));
+            auto dictionaries = aux::readSnapshotDictionaries(file, header);
+            std::vector<std::vector<size_t>> remap(dictionaries.size());
+            for(size_t level = 0; level < dictionaries.size(); ++level){
+                remap[level].reserve(dictionaries[level].size());
+                for(size_t i = 0; i < dictionaries[level].size(); ++i)
+                    remap[level].push_back(traits_.addSubkey(level, dictionaries[level].key(i)));
+            }
+            clear();
+            try{
+                size_ = loadNode(file, header.data_, 0, remap, root_.get());
+            }catch(...){
+                clear();
+                throw;
+            }
+        }
+
+        /// count of threads used by clear() and destructor, copied by copy constructor and assignment
+        void setTeardownThreads(size_t threadsCount)noexcept
+        {
+            teardownThreads_ = std::max<size_t>(1, threadsCount);
         }
 
     private:
+        Iterator insertParsed(
+                const ParsedKeyT &parsedKey,
+                const ValueT &val)
+        {
+            size_t index = 0;
+            size_t leafIndex = parsedKey[ContTraitsT::SuffixLevel::leaf_Suffix];
+            auto insertFunc = [&, this](LeafNodeT *node)->ThisTypeT::Iterator
+            {
+                if(node->set(leafIndex, val))
+                    ++size_;
+                return ThisTypeT::Iterator(node, leafIndex);
+            };
+
+            return applyFunc(root_.get(), parsedKey, index, insertFunc);
+        }
+
         template<typename NodeT>
         Iterator applyFunc(
                 NodeT *node,
@@ -266,6 +623,398 @@ namespace suffix_tree{
             return func(node);
         }
 
+        template<typename NodeT>
+        Iterator lookupFunc(
+                const NodeT *node,
+                const typename ContTraitsT::ParsedKeyT &key,
+                size_t &index,
+                NodeFunctorT func)const
+        {
+            auto *childNode = node->findChild(key[index++]);
+            if(nullptr == childNode)
+                return end();
+            return lookupFunc(childNode, key, index, func);
+        }
+
+        Iterator lookupFunc(
+                LeafNodeT *node,
+                const typename ContTraitsT::ParsedKeyT &,
+                size_t &,
+                NodeFunctorT func)const
+        {
+            return func(node);
+        }
+
+        template<typename NodeT>
+        void findBatch(
+                NodeT *const *nodes,
+                const ParsedKeyT *keys,
+                size_t level,
+                size_t count,
+                Iterator *results)const
+        {
+            typedef std::remove_pointer_t<decltype(nodes[0]->findChild(0))> ChildNodeT;
+            ChildNodeT *children[BATCH_GROUP_SIZE];
+            for(size_t i = 0; i < count; ++i){
+                children[i] = (nullptr != nodes[i])? nodes[i]->findChild(keys[i][level]): nullptr;
+                if(nullptr != children[i])
+                    __builtin_prefetch(children[i]);
+            }
+            for(size_t i = 0; i < count; ++i){
+                if(nullptr != children[i])
+                    children[i]->prefetchChild(keys[i][level + 1]);
+            }
+            findBatch(children, keys, level + 1, count, results);
+        }
+
+        void findBatch(
+                LeafNodeT *const *nodes,
+                const ParsedKeyT *keys,
+                size_t level,
+                size_t count,
+                Iterator *results)const
+        {
+            for(size_t i = 0; i < count; ++i){
+                size_t leafIndex = keys[i][level];
+                if(nullptr != nodes[i] && nodes[i]->exist(leafIndex))
+                    results[i] = Iterator(nodes[i], leafIndex);
+                else
+                    results[i] = end();
+            }
+        }
+
+        template<typename NodeT>
+        void insertBatch(
+                NodeT *const *nodes,
+                const ParsedKeyT *keys,
+                size_t level,
+                size_t count,
+                const ValueT *values,
+                Iterator *results)
+        {
+            typedef std::remove_pointer_t<decltype(nodes[0]->getChild(0))> ChildNodeT;
+            ChildNodeT *children[BATCH_GROUP_SIZE];
+            for(size_t i = 0; i < count; ++i){
+                children[i] = (nullptr != nodes[i])? nodes[i]->getChild(keys[i][level]): nullptr;
+                if(nullptr != children[i])
+                    __builtin_prefetch(children[i]);
+            }
+            for(size_t i = 0; i < count; ++i){
+                if(nullptr != children[i])
+                    children[i]->prefetchChild(keys[i][level + 1]);
+            }
+            insertBatch(children, keys, level + 1, count, values, results);
+        }
+
+        void insertBatch(
+                LeafNodeT *const *nodes,
+                const ParsedKeyT *keys,
+                size_t level,
+                size_t count,
+                const ValueT *values,
+                Iterator *results)
+        {
+            for(size_t i = 0; i < count; ++i){
+                if(nullptr == nodes[i]){
+                    results[i] = end();
+                    continue;
+                }
+                size_t leafIndex = keys[i][level];
+                if(nodes[i]->set(leafIndex, values[i]))
+                    ++size_;
+                results[i] = Iterator(nodes[i], leafIndex);
+            }
+        }
+
+        /// calls func(part, from, to) for partsCount ranges of [0, count), part 0 runs on the calling thread.
+        /// If thread can't be started its part runs on the calling thread too
+        template<typename FuncT>
+        static void runParallel(
+                size_t partsCount,
+                size_t count,
+                FuncT func)
+        {
+            std::vector<std::thread> threads;
+            threads.reserve(partsCount);
+            size_t step = (count + partsCount - 1) / partsCount;
+            for(size_t part = 1; part < partsCount; ++part){
+                size_t from = std::min(count, part * step);
+                try{
+                    threads.emplace_back(func, part, from, std::min(count, from + step));
+                }catch(const std::system_error &){
+                    func(part, from, std::min(count, from + step));
+                }
+            }
+            func(0, 0, std::min(count, step));
+            for(auto &thread: threads)
+                thread.join();
+        }
+
+        /// stable LSD radix sort of order by parsed keys, every pass is counting sort of one level
+        void radixSort(
+                const std::vector<ParsedKeyT> &parsedKeys,
+                std::vector<size_t> &order)const
+        {
+            std::vector<size_t> tmp(order.size());
+            std::vector<size_t> offsets;
+            for(size_t level = ContTraitsT::SuffixLevel::total_Suffix; level-- > 0;){
+                offsets.assign(traits_.suffixCount(static_cast<typename ContTraitsT::SuffixLevel>(level)) + 1, 0);
+                for(auto idx: order)
+                    ++offsets[parsedKeys[idx][level] + 1];
+                for(size_t i = 1; i < offsets.size(); ++i)
+                    offsets[i] += offsets[i - 1];
+                for(auto idx: order)
+                    tmp[offsets[parsedKeys[idx][level]]++] = idx;
+                std::swap(tmp, order);
+            }
+        }
+
+        /// builds children of node from sorted keys [from, to) with the same subkeys up to level,
+        /// returns count of new values
+        template<typename NodeT, typename RandomItT>
+        size_t buildSubtree(
+                NodeT *node,
+                size_t level,
+                const size_t *from,
+                const size_t *to,
+                const std::vector<ParsedKeyT> &parsedKeys,
+                RandomItT first,
+                AllocatorT &pool)
+        {
+            typedef std::remove_pointer_t<decltype(node->findChild(0))> ChildNodeT;
+            size_t added = 0;
+            while(from != to){
+                size_t index = parsedKeys[*from][level];
+                const size_t *groupEnd = from + 1;
+                while(groupEnd != to && index == parsedKeys[*groupEnd][level])
+                    ++groupEnd;
+                ChildNodeT *child = pool.template allocatorOf<ChildNodeT>().create(allocator_, node, index, traits_);
+                try{
+                    node->attachChild(index, child);
+                }catch(...){
+                    pool.template allocatorOf<ChildNodeT>().destroy(child);
+                    throw;
+                }
+                added += buildSubtree(child, level + 1, from, groupEnd, parsedKeys, first, pool);
+                from = groupEnd;
+            }
+            return added;
+        }
+
+        template<typename RandomItT>
+        size_t buildSubtree(
+                LeafNodeT *node,
+                size_t level,
+                const size_t *from,
+                const size_t *to,
+                const std::vector<ParsedKeyT> &parsedKeys,
+                RandomItT first,
+                AllocatorT &)
+        {
+            size_t added = 0;
+            for(; from != to; ++from){
+                if(node->set(parsedKeys[*from][level], first[*from].second))
+                    ++added;
+            }
+            return added;
+        }
+
+        std::vector<const SubtreeNodeT *> subtrees()const
+        {
+            std::vector<const SubtreeNodeT *> res;
+            for(const SubtreeNodeT *node = root_->begin(); nullptr != node; node = root_->nextNode(node))
+                res.push_back(node);
+            return res;
+        }
+
+        /// node with the same index as src and without children, leaf is copied with values
+        template<typename NodeT, typename ParentNodeT>
+        NodeT *createCopy(
+                const NodeT *src,
+                ParentNodeT *parent,
+                AllocatorT &pool)
+        {
+            return pool.template allocatorOf<NodeT>().create(allocator_, parent, src->index(), traits_);
+        }
+
+        template<typename ParentNodeT>
+        LeafNodeT *createCopy(
+                const LeafNodeT *src,
+                ParentNodeT *parent,
+                AllocatorT &pool)
+        {
+            return pool.template allocatorOf<LeafNodeT>().create(*src, allocator_, parent, src->index(), traits_);
+        }
+
+        template<typename NodeT>
+        void copyChildren(
+                const NodeT *src,
+                NodeT *dst,
+                AllocatorT &pool)
+        {
+            typedef std::remove_pointer_t<decltype(src->findChild(0))> ChildNodeT;
+            for(const ChildNodeT *child = src->begin(); nullptr != child;){
+                ChildNodeT *copy = createCopy(child, dst, pool);
+                try{
+                    dst->attachChild(child->index(), copy);
+                }catch(...){
+                    pool.template allocatorOf<ChildNodeT>().destroy(copy);
+                    throw;
+                }
+                copyChildren(child, copy, pool);
+                size_t index = src->next(child->index());
+                child = (suffix_tree_impl::INVALID_INDEX != index)? src->findChild(index): nullptr;
+            }
+        }
+
+        void copyChildren(
+                const LeafNodeT *,
+                LeafNodeT *,
+                AllocatorT &)noexcept
+        {}
+
+        /// pools of workers are adopted by the tree allocator, subtrees are linked under the root
+        /// or destroyed if any worker failed
+        void linkSubtrees(
+                std::vector<std::unique_ptr<AllocatorT>> &pools,
+                const std::vector<std::exception_ptr> &errors,
+                std::vector<SubtreeNodeT *> &subtrees)
+        {
+            for(auto &pool: pools)
+                allocator_.adopt(*pool);
+            for(auto &error: errors){
+                if(nullptr == error)
+                    continue;
+                for(auto *node: subtrees)
+                    allocator_.template allocatorOf<SubtreeNodeT>().destroy(node);
+                std::rethrow_exception(error);
+            }
+            for(auto *node: subtrees)
+                root_->attachChild(node->index(), node);
+        }
+
+        /// writes children before the node, returns offset of the node
+        template<typename NodeT>
+        uint64_t saveNode(
+                aux::SnapshotWriter &writer,
+                const NodeT *node)const
+        {
+            typedef std::remove_pointer_t<decltype(node->findChild(0))> ChildNodeT;
+            std::vector<aux::SnapshotChild> children;
+            for(const ChildNodeT *child = node->begin(); nullptr != child;){
+                children.push_back(aux::SnapshotChild{child->index(), saveNode(writer, child)});
+                size_t index = node->next(child->index());
+                child = (suffix_tree_impl::INVALID_INDEX != index)? node->findChild(index): nullptr;
+            }
+            writer.align();
+            uint64_t offset = writer.offset();
+            writer.writeValue(static_cast<uint64_t>(children.size()));
+            writer.write(children.data(), children.size()*sizeof(aux::SnapshotChild));
+            return offset;
+        }
+
+        uint64_t saveNode(
+                aux::SnapshotWriter &writer,
+                const LeafNodeT *node)const
+        {
+            std::vector<uint64_t> indexes;
+            std::vector<ValueT> values;
+            for(size_t index = node->begin(); suffix_tree_impl::INVALID_INDEX != index; index = node->next(index)){
+                indexes.push_back(index);
+                values.push_back(node->get(index));
+            }
+            writer.align();
+            uint64_t offset = writer.offset();
+            writer.writeValue(static_cast<uint64_t>(indexes.size()));
+            writer.write(indexes.data(), indexes.size()*sizeof(uint64_t));
+            writer.align();
+            writer.write(values.data(), values.size()*sizeof(ValueT));
+            return offset;
+        }
+
+        /// builds children of node from the image, returns count of values
+        template<typename NodeT>
+        size_t loadNode(
+                const aux::MappedFile &file,
+                uint64_t offset,
+                size_t level,
+                const std::vector<std::vector<size_t>> &remap,
+                NodeT *node)
+        {
+            const uint64_t *count = file.at<uint64_t>(offset);
+            const aux::SnapshotChild *children = (nullptr != count)?
+                    file.at<aux::SnapshotChild>(offset + sizeof(uint64_t), *count): nullptr;
+            if(nullptr == children)
+                throw std::runtime_error("SuffixTree::load: snapshot is corrupted");
+            size_t res = 0;
+            for(size_t i = 0; i < *count; ++i){
+                /// children are written before parents, so offsets go backward and recursion ends
+                if(children[i].index_ >= remap[level].size() || children[i].offset_ >= offset)
+                    throw std::runtime_error("SuffixTree::load: snapshot is corrupted");
+                res += loadNode(file, children[i].offset_, level + 1, remap, node->getChild(remap[level][children[i].index_]));
+            }
+            return res;
+        }
+
+        size_t loadNode(
+                const aux::MappedFile &file,
+                uint64_t offset,
+                size_t level,
+                const std::vector<std::vector<size_t>> &remap,
+                LeafNodeT *node)
+        {
+            const uint64_t *count = file.at<uint64_t>(offset);
+            const uint64_t *indexes = (nullptr != count)? file.at<uint64_t>(offset + sizeof(uint64_t), *count): nullptr;
+            const ValueT *values = nullptr;
+            if(nullptr != indexes)
+                values = file.at<ValueT>((offset + (*count + 1)*sizeof(uint64_t) + 7) & ~uint64_t(7), *count);
+            if(nullptr == values)
+                throw std::runtime_error("SuffixTree::load: snapshot is corrupted");
+            size_t res = 0;
+            for(size_t i = 0; i < *count; ++i){
+                if(indexes[i] >= remap[level].size())
+                    throw std::runtime_error("SuffixTree::load: snapshot is corrupted");
+                if(node->set(remap[level][indexes[i]], values[i]))
+                    ++res;
+            }
+            return res;
+        }
+
+        /// runs destructors of all nodes of the subtree, slots stay in the pools
+        template<typename NodeT>
+        static void destroySubtree(NodeT *node)noexcept
+        {
+            typedef std::remove_pointer_t<decltype(node->findChild(0))> ChildNodeT;
+            for(const ChildNodeT *child = node->begin(); nullptr != child;){
+                size_t index = node->next(child->index());
+                destroySubtree(const_cast<ChildNodeT *>(child));
+                child = (suffix_tree_impl::INVALID_INDEX != index)? node->findChild(index): nullptr;
+            }
+            node->detachChildren();
+            node->~NodeT();
+        }
+
+        static void destroySubtree(LeafNodeT *node)noexcept
+        {
+            node->~LeafNodeT();
+        }
+
+        /// removes empty nodes from the bottom of the tree up to the root
+        template<typename NodeT>
+        void prune(
+                NodeT *node)
+        {
+            if(!node->empty())
+                return;
+            auto *parentNode = node->parent();
+            parentNode->eraseChild(node->index());
+            prune(parentNode);
+        }
+
+        void prune(
+                RootNodeT *)noexcept
+        {}
+
         template<typename NodeT>
         Iterator applyFunc(
                 const NodeT *node,
@@ -287,8 +1036,10 @@ namespace suffix_tree{
     private:
         TraitsT traits_;
 
+        AllocatorT allocator_;
         RootNodePtrT root_;
         size_t size_;
+        size_t teardownThreads_;
     };
 
 
@@ -10,10 +10,12 @@
 #include <functional>
 #include <boost/dynamic_bitset.hpp>
 
+#include "ContAllocator.h"
+#include "ChildNodes.h"
+
 namespace suffix_tree{
 
     namespace suffix_tree_impl{
-        const size_t INVALID_INDEX = std::numeric_limits<size_t>::max();
 
         template<typename MetaT, typename MetaT::SuffixLevel NodeLevelT>
         class SuffixNode;
@@ -27,14 +29,16 @@ namespace suffix_tree{
             static const typename MetaT::SuffixLevel NEXT_NODE_LEVEL = static_cast<typename MetaT::SuffixLevel>(NODE_LEVEL + 1);
             typedef typename MetaT::template NodeTraits<NEXT_NODE_LEVEL>::NodeTypeT ChildNodeT;
             typedef ChildNodeT *ChildNodePtrT;
-            typedef std::vector<ChildNodeT *> SubNotesT;
+            typedef ChildNodes<ChildNodeT> SubNotesT;
 
         public:
+            typedef LevelNodeAllocators<MetaT> AllocatorT;
+
             RootNode(
+                    AllocatorT &allocator,
                     const MetaT &metaInfo):
-                    metaInfo_(metaInfo)
+                    metaInfo_(metaInfo), allocator_(allocator)
             {
-                childNodes_.assign(metaInfo_.suffixCount(NODE_LEVEL), nullptr);
             }
 
             ~RootNode()
@@ -44,114 +48,125 @@ namespace suffix_tree{
 
             RootNode(
                     const RootNode &nd,
+                    AllocatorT &allocator,
                     const MetaT &metaInfo):
-                    metaInfo_(metaInfo)
+                    metaInfo_(metaInfo), allocator_(allocator)
             {
-                SubNotesT tmp;
-                tmp.reserve(nd.childNodes_.size());
-                std::for_each(
-                        std::begin(nd.childNodes_), std::end(nd.childNodes_),
-                        [&](const ChildNodeT *val){
-                            if(nullptr != val){
-                                /*ChildNodePtrT chld = allocator_.template allocator<NEXT_NODE_LEVEL>().
-                                        make_unique(*val, allocator_, this, tmp.size(), metaInfo_);
-                                tmp.emplace_back(chld.get());
-                                chld.release();*/
-                                tmp.emplace_back(new ChildNodeT(*val, this, tmp.size(), metaInfo_));
-                            }else
-                                tmp.emplace_back(nullptr);
-                        });
-                std::swap(tmp, childNodes_);
+                auto &alloc = allocator_.template allocator<NEXT_NODE_LEVEL>();
+                size_t capacity = metaInfo_.suffixCount(NODE_LEVEL);
+                try{
+                    nd.childNodes_.forEach(
+                            [&](size_t index, const ChildNodeT *val){
+                                ChildNodePtrT chld = alloc.create(*val, allocator_, this, index, metaInfo_);
+                                try{
+                                    childNodes_.insert(index, chld, capacity);
+                                }catch(...){
+                                    alloc.destroy(chld);
+                                    throw;
+                                }
+                            });
+                }catch(...){
+                    clear();
+                    throw;
+                }
             }
 
-            RootNode &operator=(
-                    const RootNode nd)
-            {
-                std::swap(metaInfo_, nd.metaInfo_);
-                std::swap(childNodes_, nd.childNodes_);
-            }
+            RootNode(const RootNode &nd) = delete;
+            RootNode &operator=(const RootNode nd) = delete;
 
             ChildNodeT *getChild(
                     size_t index)
             {
-                if(childNodes_.size() <= index)
-                    childNodes_.resize(index + 1, nullptr);
-                if(nullptr == childNodes_[index]){
-                    /*childNodes_[index] = allocator_.template allocator<NEXT_NODE_LEVEL>().
-                            create(allocator_, this, index, metaInfo_);*/
-                    childNodes_[index] = new ChildNodeT(this, index, metaInfo_);
+                ChildNodePtrT chld = childNodes_.find(index);
+                if(nullptr != chld)
+                    return chld;
+
+                auto &alloc = allocator_.template allocator<NEXT_NODE_LEVEL>();
+                chld = alloc.create(allocator_, this, index, metaInfo_);
+                try{
+                    childNodes_.insert(index, chld, metaInfo_.suffixCount(NODE_LEVEL));
+                }catch(...){
+                    alloc.destroy(chld);
+                    throw;
                 }
-                return childNodes_[index];
+                return chld;
             }
 
             ChildNodeT *findChild(
-                    size_t index)noexcept
+                    size_t index)const noexcept
             {
-                if(childNodes_.size() <= index)
-                    return nullptr;
-                return childNodes_[index];
+                return childNodes_.find(index);
             }
 
-            size_t next(
+            /// links child built outside of the node, slot at index has to be empty
+            void attachChild(
+                    size_t index,
+                    ChildNodeT *chld)
+            {
+                childNodes_.insert(index, chld, metaInfo_.suffixCount(NODE_LEVEL));
+            }
+
+            /// forgets all children without destroying them, they have to be destroyed by the caller
+            void detachChildren()noexcept
+            {
+                childNodes_.clear();
+            }
+
+            void prefetchChild(
                     size_t index)const noexcept
             {
-                if(childNodes_.size() <= index)
-                    return INVALID_INDEX;
+                childNodes_.prefetch(index);
+            }
 
-                auto childNodeCount = childNodes_.size();
-                for(size_t i = index + 1; i < childNodeCount; ++i)
-                {
-                    if(nullptr != childNodes_[i])
-                        return i;
-                }
-                return INVALID_INDEX;
+            void eraseChild(
+                    size_t index)
+            {
+                allocator_.template allocator<NEXT_NODE_LEVEL>().destroy(childNodes_.erase(index));
+            }
+
+            bool empty()const noexcept
+            {
+                return childNodes_.empty();
+            }
+
+            size_t next(
+                    size_t index)const noexcept
+            {
+                return childNodes_.next(index);
             }
 
             const ChildNodeT *begin()const noexcept
             {
-                auto it = std::find_if(
-                        std::begin(childNodes_),
-                        std::end(childNodes_),
-                        [](const ChildNodeT * val){return nullptr != val;});
-                if(std::end(childNodes_) == it)
+                size_t index = childNodes_.first();
+                if(INVALID_INDEX == index)
                     return nullptr;
-                return *it;
+                return childNodes_.find(index);
             }
 
             const ChildNodeT *nextNode(
-                    const ChildNodeT *node)const
+                    const ChildNodeT *node)const noexcept
             {
-                auto it = std::find(
-                        std::begin(childNodes_), std::end(childNodes_), node);
-                if(std::end(childNodes_) == it)
+                size_t index = childNodes_.next(node->index());
+                if(INVALID_INDEX == index)
                     return nullptr;
-
-                ++it;
-                auto nextIt = std::find_if(
-                        it, std::end(childNodes_),
-                        [](const ChildNodeT *val){return nullptr != val;});
-                if(std::end(childNodes_) != nextIt && nullptr != *nextIt)
-                    return *nextIt;
-                return nullptr;
+                return childNodes_.find(index);
             }
 
             void clear()
             {
-                SubNotesT tmp;
-                std::swap(tmp, childNodes_);
-
-                //auto &alloc = allocator_.template allocator<NEXT_NODE_LEVEL>();
-                std::for_each(std::begin(tmp), std::end(tmp),
-                              [](ChildNodeT *val)
-                              {
-                                //alloc.destroy(val);
-                                delete val;
-                              });
+                auto &alloc = allocator_.template allocator<NEXT_NODE_LEVEL>();
+                childNodes_.forEach(
+                        [&alloc](size_t, ChildNodeT *val)
+                        {
+                            alloc.destroy(val);
+                        });
+                childNodes_.clear();
             }
 
         private:
             SubNotesT childNodes_;
             const MetaT &metaInfo_;
+            AllocatorT &allocator_;
         };
 
         template<typename MetaT, typename MetaT::SuffixLevel NODE_LEVEL>
@@ -165,44 +180,49 @@ namespace suffix_tree{
 
             typedef typename PrevNodeTraitsT::NodeTypeT ParentNodeT;
             typedef typename NextNodeTraitsT::NodeTypeT ChildNodeT;
-            typedef std::vector<ChildNodeT *> SubNotesT;
+            typedef ChildNodes<ChildNodeT> SubNotesT;
 
             typedef ChildNodeT *ChildNodePtrT;
 
         public:
+            typedef LevelNodeAllocators<MetaT> AllocatorT;
+
             SuffixNode(
+                    AllocatorT &allocator,
                     ParentNodeT *parentNode,
                     size_t index,
                     const MetaT &metaInfo):
-                    metaInfo_(metaInfo),
+                    metaInfo_(metaInfo), allocator_(allocator),
                     parentNode_(parentNode), selfIndex_(index)
             {
-                childNodes_.assign(metaInfo_.suffixCount(NODE_LEVEL), nullptr);
             }
 
             SuffixNode(
                     const SuffixNode &nd,
+                    AllocatorT &allocator,
                     ParentNodeT *parentNode,
                     size_t index,
                     const MetaT &metaInfo):
-                    metaInfo_(metaInfo),
+                    metaInfo_(metaInfo), allocator_(allocator),
                     parentNode_(parentNode), selfIndex_(index)
             {
-                SubNotesT tmp;
-                tmp.reserve(nd.childNodes_.size());
-                std::for_each(
-                        std::begin(nd.childNodes_), std::end(nd.childNodes_),
-                        [&](const ChildNodeT *val){
-                            if(nullptr != val){
-                                /*ChildNodePtrT chld = allocator_.template allocator<NEXT_NODE_LEVEL>().
-                                        make_unique(*val, allocator_, this, tmp.size(), metaInfo_);
-                                tmp.emplace_back(chld.get());
-                                chld.release();*/
-                                tmp.emplace_back(new ChildNodeT(*val, this, tmp.size(), metaInfo_));
-                            }else
-                                tmp.emplace_back(nullptr);
-                        });
-                std::swap(tmp, childNodes_);
+                auto &alloc = allocator_.template allocator<NEXT_NODE_LEVEL>();
+                size_t capacity = metaInfo_.suffixCount(NODE_LEVEL);
+                try{
+                    nd.childNodes_.forEach(
+                            [&](size_t index, const ChildNodeT *val){
+                                ChildNodePtrT chld = alloc.create(*val, allocator_, this, index, metaInfo_);
+                                try{
+                                    childNodes_.insert(index, chld, capacity);
+                                }catch(...){
+                                    alloc.destroy(chld);
+                                    throw;
+                                }
+                            });
+                }catch(...){
+                    clear();
+                    throw;
+                }
                 selfIndex_ = nd.selfIndex_;
             }
 
@@ -217,66 +237,78 @@ namespace suffix_tree{
             ChildNodeT *getChild(
                     size_t index)
             {
-                if(childNodes_.size() <= index)
-                    childNodes_.resize(index + 1, nullptr);
-
-                if(nullptr == childNodes_[index]){
-                    /*childNodes_[index] = allocator_.template allocator<NEXT_NODE_LEVEL>().
-                            create(allocator_, this, index, metaInfo_);*/
-                    childNodes_[index] = new ChildNodeT(this, index, metaInfo_);
+                ChildNodePtrT chld = childNodes_.find(index);
+                if(nullptr != chld)
+                    return chld;
+
+                auto &alloc = allocator_.template allocator<NEXT_NODE_LEVEL>();
+                chld = alloc.create(allocator_, this, index, metaInfo_);
+                try{
+                    childNodes_.insert(index, chld, metaInfo_.suffixCount(NODE_LEVEL));
+                }catch(...){
+                    alloc.destroy(chld);
+                    throw;
                 }
-
-                return childNodes_[index];
+                return chld;
             }
 
             ChildNodeT *findChild(
                     size_t index)const noexcept
             {
-                if(childNodes_.size() < index)
-                    return nullptr;
+                return childNodes_.find(index);
+            }
+
+            /// links child built outside of the node, slot at index has to be empty
+            void attachChild(
+                    size_t index,
+                    ChildNodeT *chld)
+            {
+                childNodes_.insert(index, chld, metaInfo_.suffixCount(NODE_LEVEL));
+            }
 
-                return childNodes_[index];
+            /// forgets all children without destroying them, they have to be destroyed by the caller
+            void detachChildren()noexcept
+            {
+                childNodes_.clear();
             }
 
-            size_t next(
+            void prefetchChild(
                     size_t index)const noexcept
             {
-                if(childNodes_.size() <= index)
-                    return INVALID_INDEX;
+                childNodes_.prefetch(index);
+            }
 
-                auto childNodeCount = childNodes_.size();
-                for(size_t i = index + 1; i < childNodeCount; ++i)
-                {
-                    if(nullptr != childNodes_[i])
-                        return i;
-                }
-                return INVALID_INDEX;
+            void eraseChild(
+                    size_t index)
+            {
+                allocator_.template allocator<NEXT_NODE_LEVEL>().destroy(childNodes_.erase(index));
+            }
+
+            bool empty()const noexcept
+            {
+                return childNodes_.empty();
+            }
+
+            size_t next(
+                    size_t index)const noexcept
+            {
+                return childNodes_.next(index);
             }
 
             const ChildNodeT *begin()const
             {
-                auto it = std::find_if(
-                        std::begin(childNodes_), std::end(childNodes_),
-                        [](const ChildNodeT * val){return nullptr != val;});
-                if(std::end(childNodes_) == it)
+                size_t index = childNodes_.first();
+                if(INVALID_INDEX == index)
                     return nullptr;
-                return *it;
+                return childNodes_.find(index);
             }
 
             const ChildNodeT *nextNode(
-                    const ChildNodeT *node)const
+                    const ChildNodeT *node)const noexcept
             {
-                typename SubNotesT::const_iterator it = std::find(
-                        std::begin(childNodes_), std::end(childNodes_), node);
-                if(std::end(childNodes_) == it)
-                    return nullptr;
-
-                ++it;
-                auto nextIt = std::find_if(
-                        it, childNodes_.end(),
-                        [](const ChildNodeT *val){return nullptr != val;});
-                if(childNodes_.end() != nextIt && nullptr != *nextIt)
-                    return *nextIt;
+                size_t index = childNodes_.next(node->index());
+                if(INVALID_INDEX != index)
+                    return childNodes_.find(index);
 
                 auto nextNode = parentNode_->nextNode(this);
                 if(nullptr != nextNode)
@@ -286,21 +318,22 @@ namespace suffix_tree{
 
             void clear()
             {
-                SubNotesT tmp(metaInfo_.suffixCount(NODE_LEVEL), nullptr);
-                std::swap(tmp, childNodes_);
-
-                //auto &alloc = allocator_.template allocator<NEXT_NODE_LEVEL>();
-                std::for_each(
-                        std::begin(tmp), std::end(tmp),
-                        [](ChildNodeT *val)
+                auto &alloc = allocator_.template allocator<NEXT_NODE_LEVEL>();
+                childNodes_.forEach(
+                        [&alloc](size_t, ChildNodeT *val)
                         {
-                            //alloc.destroy(val);
-                            delete val;
+                            alloc.destroy(val);
                         });
+                childNodes_.clear();
             }
 
+            ParentNodeT *parent()const noexcept{return parentNode_;}
+
+            size_t index()const noexcept{return selfIndex_;}
+
         private:
             const MetaT &metaInfo_;
+            AllocatorT &allocator_;
             SubNotesT childNodes_;
             ParentNodeT *parentNode_;
             size_t selfIndex_;
@@ -322,11 +355,14 @@ namespace suffix_tree{
             typedef boost::dynamic_bitset<> ValueOptionalT;
 
         public:
+            typedef LevelNodeAllocators<MetaT> AllocatorT;
+
             LeafNode(
+                    AllocatorT &,
                     ParentNodeT *parentNode,
                     size_t index,
                     const MetaT &metaInfo):
-                    parentNode_(parentNode), selfIndex_(index)
+                    parentNode_(parentNode), selfIndex_(index), count_(0)
             {
                 size_t count = metaInfo.suffixCount(MetaT::SuffixLevel::leaf_Suffix);
                 values_.resize(count, NodeTraitsT::defaultValue());
@@ -335,10 +371,11 @@ namespace suffix_tree{
 
             LeafNode(
                     const LeafNode &nd,
+                    AllocatorT &,
                     ParentNodeT *parentNode,
                     size_t index,
                     const MetaT &metaInfo):
-                    parentNode_(parentNode), selfIndex_(index)
+                    parentNode_(parentNode), selfIndex_(index), count_(nd.count_)
             {
                 ValuesT tmp;
                 tmp.reserve(nd.values_.size());
@@ -369,6 +406,7 @@ namespace suffix_tree{
                     optional_.resize(index + 1, VALUE_MISSED);
                     values_[index] = val;
                     optional_[index] = VALUE_EXIST;
+                    ++count_;
                     return true;
                 }
 
@@ -376,6 +414,7 @@ namespace suffix_tree{
                 if(VALUE_EXIST == optional_[index])
                     return false;
                 optional_[index] = VALUE_EXIST;
+                ++count_;
                 return true;
             }
 
@@ -393,6 +432,13 @@ namespace suffix_tree{
                 return (optional_.size() > index) && (VALUE_EXIST == optional_[index]);
             }
 
+            void prefetchChild(
+                    size_t index)const noexcept
+            {
+                if(index < values_.size())
+                    __builtin_prefetch(values_.data() + index);
+            }
+
             bool erase(
                     size_t index)
             {
@@ -400,9 +446,15 @@ namespace suffix_tree{
                     return false;
                 values_[index] = NodeTraitsT::defaultValue();
                 optional_[index] = VALUE_MISSED;
+                --count_;
                 return true;
             }
 
+            bool empty()const noexcept
+            {
+                return 0 == count_;
+            }
+
             size_t next(
                     size_t index)const noexcept
             {
@@ -428,15 +480,19 @@ namespace suffix_tree{
                 values_.resize(count, ValueT());
                 optional_.clear();
                 optional_.resize(count, VALUE_MISSED);
+                count_ = 0;
             }
 
-            const ParentNodeT *parent()const noexcept{return parentNode_;}
+            ParentNodeT *parent()const noexcept{return parentNode_;}
+
+            size_t index()const noexcept{return selfIndex_;}
 
         private:
             ParentNodeT *parentNode_;
             mutable ValuesT values_;
             ValueOptionalT optional_;
             size_t selfIndex_;
+            size_t count_;
         };
 
     }
@@ -6,7 +6,9 @@
 
 #include <string>
 #include <cstring>
+#include <array>
 #include "ContBuilderKeys.h"
+#include "KeyTokenizer.h"
 #include "SuffixTree.h"
 
 namespace aux{
@@ -76,12 +78,13 @@ namespace aux{
     class SuffixTreeTraits {
     public:
         typedef ContKeyT KeyT;
+        typedef aux::KeyViewT KeyViewT;
         typedef ContValueT ValueT;
         typedef SuffixTreeTraits<LevelsT, ContKeyT, ContValueT> ThisTypeT;
     public:
         static constexpr size_t NUMBER_LEVELS = LevelsT;
         typedef typename SuffixLevelEnum<LevelsT>::Levels SuffixLevel;
-        typedef size_t ParsedKeyT[SuffixLevel::total_Suffix];
+        typedef std::array<size_t, SuffixLevel::total_Suffix> ParsedKeyT;
 
         template<SuffixLevel LevelIdxT, class DummyT = void>
         struct NodeTraits {
@@ -216,54 +219,68 @@ namespace aux{
         }
 
         bool parseKey(
-                const KeyT &key,
+                KeyViewT key,
                 SuffixTreeTraits::ParsedKeyT &res) const
         {
-            size_t currLevel = 0;
+            size_t tokenLastPosition[SuffixTreeTraits::SuffixLevel::total_Suffix];
+            if(!tokenize(key, tokenLastPosition))
+                return false;
             size_t startIdx = 0;
-            size_t totalLen = key.length();
-            for(size_t i = 0; i < totalLen; ++i){
-                if(delimeter_ == key[i]){
-                    size_t index = 0;
-                    if(!getKeyIndex(currLevel, key, startIdx, i, index))
-                        return false;
-                    res[currLevel] = index;
-                    ++currLevel;
-                    startIdx = i + 1; ///skip delimeter
-                }
-            }
-            if(startIdx < totalLen){
+            for(size_t i = 0; i < SuffixTreeTraits::SuffixLevel::total_Suffix; ++i){
+                size_t lastIdx = tokenLastPosition[i];
                 size_t index = 0;
-                if(!getKeyIndex(currLevel, key, startIdx, totalLen, index))
+                if(!getKeyIndex(i, key, startIdx, lastIdx, index))
                     return false;
-                res[currLevel] = index;
+                res[i] = index;
+                startIdx = lastIdx + 1; ///skip delimeter
             }
             return true;
         }
 
-        bool parseNewKey(
-                const KeyT &key,
-                SuffixTreeTraits::ParsedKeyT &res)
+        bool parseKey(
+                const char *key,
+                size_t length,
+                SuffixTreeTraits::ParsedKeyT &res) const
         {
-            size_t currLevel = 0;
-            size_t totalLen = key.length();
-            size_t lenLeft = totalLen;
-            size_t tokenLastPosition[SuffixTreeTraits::SuffixLevel::total_Suffix];
-            const char *startPtr = key.c_str();
-            const char *bufferPtr = startPtr;
-            const char *ptr = nullptr;
-            while(nullptr != (ptr = reinterpret_cast<const char *>(memchr(bufferPtr, delimeter_, lenLeft)))){
-                tokenLastPosition[currLevel] = ptr - startPtr;
-                ++currLevel;
-                if(SuffixTreeTraits::SuffixLevel::total_Suffix <= currLevel) /// too many tokens in key
+            return parseKey(KeyViewT(key, length), res);
+        }
+
+        /// returns indexes of subkeys, all indexes are INVALID_INDEX if key is unknown
+        SuffixTreeTraits::ParsedKeyT parseKey(
+                KeyViewT key) const
+        {
+            SuffixTreeTraits::ParsedKeyT res;
+            if(!parseKey(key, res))
+                res.fill(suffix_tree::suffix_tree_impl::INVALID_INDEX);
+            return res;
+        }
+
+        /// checks that every index of the parsed key refers to the known subkey
+        bool isValid(
+                const SuffixTreeTraits::ParsedKeyT &key) const noexcept
+        {
+            for(size_t i = 0; i < key.size(); ++i){
+                if(key[i] >= keys_.suffixCount(i))
                     return false;
-                lenLeft -= ptr - bufferPtr + 1;
-                bufferPtr = ptr + 1;
             }
+            return true;
+        }
+
+        bool parseNewKey(
+                const char *key,
+                size_t length,
+                SuffixTreeTraits::ParsedKeyT &res)
+        {
+            return parseNewKey(KeyViewT(key, length), res);
+        }
 
-            if(SuffixTreeTraits::SuffixLevel::total_Suffix != currLevel + 1)
+        bool parseNewKey(
+                KeyViewT key,
+                SuffixTreeTraits::ParsedKeyT &res)
+        {
+            size_t tokenLastPosition[SuffixTreeTraits::SuffixLevel::total_Suffix];
+            if(!tokenize(key, tokenLastPosition))
                 return false;
-            tokenLastPosition[currLevel] = totalLen;
 
             size_t startIdx = 0;
             for(size_t i = 0; i < SuffixTreeTraits::SuffixLevel::total_Suffix; ++i){
@@ -303,38 +320,87 @@ namespace aux{
             return keys_.suffixCount(level);
         }
 
+        /// subkeys of the level ordered by index
+        std::vector<KeyViewT> subkeys(
+                size_t level) const
+        {
+            return keys_.keys(level);
+        }
+
+        /// looks up index of the subkey of the level, dictionary is not changed
+        bool getKeyIndex(
+                size_t level,
+                KeyViewT subkey,
+                size_t &index) const
+        {
+            return keys_.getKeyIndex(level, subkey, index);
+        }
+
+        /// returns index of the subkey, unknown subkey is added to the level
+        size_t addSubkey(
+                size_t level,
+                KeyViewT subkey)
+        {
+            size_t index = 0;
+            if(!keys_.getKeyIndex(level, subkey, index))
+                index = keys_.addKey(level, subkey);
+            return index;
+        }
+
+        char delimeter() const noexcept{return delimeter_;}
+
+        static ValueT defaultValue(){return ValueT();}
+
+        /// builds perfect hashes of subkey dictionaries, call when dictionaries are final.
+        /// Returns false if any level stays on the flat map
+        bool freeze()
+        {
+            return keys_.freeze();
+        }
+
+        bool frozen() const noexcept
+        {
+            return keys_.frozen();
+        }
+
+        /// resolves short subkeys of the level by integer compares until the level is frozen
+        void enableShortKeys(
+                SuffixLevel level)
+        {
+            keys_.enableShortKeys(level);
+        }
+
     protected:
+        /// fills end positions of all subkeys, fails if count of subkeys differs from count of levels
+        bool tokenize(
+                KeyViewT key,
+                size_t (&tokenLastPosition)[SuffixTreeTraits::SuffixLevel::total_Suffix]) const
+        {
+            const size_t delimiters = SuffixTreeTraits::SuffixLevel::leaf_Suffix;
+            if(delimiters != findDelimiters(key.data(), key.length(), delimeter_, tokenLastPosition, delimiters))
+                return false;
+            tokenLastPosition[delimiters] = key.length();
+            return true;
+        }
+
         bool getKeyIndex(
                 size_t level,
-                const KeyT &key,
+                KeyViewT key,
                 size_t startIdx,
                 size_t endIdx,
                 size_t &index) const
         {
-            const Key2IndexT &levelKeys = keys_.level(level);
-            KeyViewT k(key.c_str() + startIdx,  endIdx - startIdx);
-            auto it = levelKeys.find(k);
-            if(std::end(levelKeys) == it)
-                return false;
-            index = it->second;
-            return true;
+            return keys_.getKeyIndex(level, KeyViewT(key.data() + startIdx,  endIdx - startIdx), index);
         }
 
         void getNewKeyIndex(
                 size_t level,
-                const KeyT &key,
+                KeyViewT key,
                 size_t startIdx,
                 size_t endIdx,
                 size_t &index)
         {
-            const Key2IndexT &levelKeys = keys_.level(level);
-            KeyViewT k(key.c_str() + startIdx,  endIdx - startIdx);
-            auto it = levelKeys.find(k);
-            if(std::end(levelKeys) != it){
-                index = it->second;
-                return;
-            }
-            index = keys_.addKey(level, k);
+            index = addSubkey(level, KeyViewT(key.data() + startIdx,  endIdx - startIdx));
         }
 
     private:
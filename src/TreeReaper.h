@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace suffix_tree{
+
+    /// Background destructor: objects passed to reap() are destroyed by the reaper thread,
+    /// so the owner doesn't wait for teardown of large trees.
+    /// Destructor of the reaper destroys everything, which is still pending.
+    class TreeReaper{
+        typedef void (*DeleterT)(void *);
+        typedef std::pair<void *, DeleterT> GarbageT;
+        typedef std::vector<GarbageT> GarbageListT;
+
+    public:
+        TreeReaper():
+            stop_(false), destroying_(0), thread_([this](){run();})
+        {}
+
+        ~TreeReaper()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cond_.notify_all();
+            thread_.join();
+        }
+
+        TreeReaper(const TreeReaper &) = delete;
+        TreeReaper &operator=(const TreeReaper &) = delete;
+
+        template<typename T>
+        void reap(std::unique_ptr<T> obj)
+        {
+            if(nullptr == obj)
+                return;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                garbage_.emplace_back(obj.get(), [](void *ptr){delete static_cast<T *>(ptr);});
+                obj.release();
+            }
+            cond_.notify_all();
+        }
+
+        /// blocks until all objects passed before are destroyed
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this](){return garbage_.empty() && 0 == destroying_;});
+        }
+
+        size_t pending()const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return garbage_.size() + destroying_;
+        }
+
+    private:
+        void run()
+        {
+            GarbageListT garbage;
+            std::unique_lock<std::mutex> lock(mutex_);
+            while(true){
+                cond_.wait(lock, [this](){return stop_ || !garbage_.empty();});
+                if(garbage_.empty())
+                    break;
+                std::swap(garbage, garbage_);
+                destroying_ = garbage.size();
+                lock.unlock();
+                for(auto &val: garbage)
+                    val.second(val.first);
+                garbage.clear();
+                lock.lock();
+                destroying_ = 0;
+                cond_.notify_all();
+            }
+        }
+
+    private:
+        mutable std::mutex mutex_;
+        std::condition_variable cond_;
+        GarbageListT garbage_;
+        bool stop_;
+        size_t destroying_;
+        std::thread thread_;
+    };
+
+}
@@ -0,0 +1,196 @@
+#include "TreeSnapshot.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace aux;
+
+namespace{
+    const char SNAPSHOT_MAGIC[8] = {'S', 'F', 'X', 'T', 'R', 'E', 'E', '\0'};
+    const uint32_t SNAPSHOT_VERSION = 1;
+}
+
+MappedFile::MappedFile(const std::string &path):
+    data_(nullptr), size_(0)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("MappedFile::MappedFile: unable to open " + path);
+    struct stat st;
+    if(0 != ::fstat(fd, &st)){
+        ::close(fd);
+        throw std::runtime_error("MappedFile::MappedFile: unable to stat " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if(0 != size_){
+        void *ptr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if(MAP_FAILED == ptr){
+            ::close(fd);
+            throw std::runtime_error("MappedFile::MappedFile: unable to map " + path);
+        }
+        data_ = static_cast<const char *>(ptr);
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if(nullptr != data_)
+        ::munmap(const_cast<char *>(data_), size_);
+}
+
+SnapshotDictionary::SnapshotDictionary():
+    count_(0), offsets_(nullptr), sorted_(nullptr), blob_(nullptr), end_(0)
+{}
+
+SnapshotDictionary::SnapshotDictionary(
+        const MappedFile &file,
+        uint64_t offset)
+{
+    const uint64_t *count = file.at<uint64_t>(offset);
+    if(nullptr == count)
+        throw std::runtime_error("SnapshotDictionary::SnapshotDictionary: dictionary is out of the file");
+    count_ = *count;
+    offsets_ = file.at<uint64_t>(offset + sizeof(uint64_t), count_ + 1);
+    if(nullptr == offsets_)
+        throw std::runtime_error("SnapshotDictionary::SnapshotDictionary: dictionary is out of the file");
+    sorted_ = file.at<uint64_t>(offset + (count_ + 2)*sizeof(uint64_t), count_);
+    uint64_t blobOffset = offset + (2*count_ + 2)*sizeof(uint64_t);
+    blob_ = file.at<char>(blobOffset, offsets_[count_]);
+    if(nullptr == sorted_ || nullptr == blob_)
+        throw std::runtime_error("SnapshotDictionary::SnapshotDictionary: dictionary is out of the file");
+    for(size_t i = 0; i < count_; ++i){
+        if(offsets_[i] > offsets_[i + 1] || sorted_[i] >= count_)
+            throw std::runtime_error("SnapshotDictionary::SnapshotDictionary: dictionary is corrupted");
+    }
+    end_ = (blobOffset + offsets_[count_] + 7) & ~uint64_t(7);
+}
+
+bool SnapshotDictionary::find(
+        std::string_view key,
+        size_t &index)const noexcept
+{
+    const uint64_t *it = std::lower_bound(
+            sorted_, sorted_ + count_, key,
+            [this](uint64_t idx, std::string_view val){return this->key(idx) < val;});
+    if(sorted_ + count_ == it || key != this->key(*it))
+        return false;
+    index = *it;
+    return true;
+}
+
+SnapshotWriter::SnapshotWriter(const std::string &path):
+    out_(path, std::ios::binary | std::ios::trunc), path_(path), offset_(0)
+{
+    if(!out_)
+        throw std::runtime_error("SnapshotWriter::SnapshotWriter: unable to create " + path);
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    writeValue(header);
+}
+
+void SnapshotWriter::write(
+        const void *data,
+        size_t size)
+{
+    out_.write(static_cast<const char *>(data), size);
+    if(!out_)
+        throw std::runtime_error("SnapshotWriter::write: unable to write " + path_);
+    offset_ += size;
+}
+
+void SnapshotWriter::align()
+{
+    static const char ZEROS[8] = {0};
+    if(0 != offset_ % 8)
+        write(ZEROS, 8 - offset_ % 8);
+}
+
+uint64_t SnapshotWriter::writeDictionary(const std::vector<std::string_view> &keys)
+{
+    align();
+    uint64_t res = offset_;
+    writeValue(static_cast<uint64_t>(keys.size()));
+    uint64_t blobSize = 0;
+    writeValue(blobSize);
+    for(auto &key: keys){
+        blobSize += key.size();
+        writeValue(blobSize);
+    }
+    std::vector<uint64_t> sorted(keys.size());
+    std::iota(std::begin(sorted), std::end(sorted), 0);
+    std::sort(std::begin(sorted), std::end(sorted), [&keys](uint64_t l, uint64_t r){return keys[l] < keys[r];});
+    write(sorted.data(), sorted.size()*sizeof(uint64_t));
+    for(auto &key: keys)
+        write(key.data(), key.size());
+    align();
+    return res;
+}
+
+void SnapshotWriter::finish(SnapshotHeader &header)
+{
+    align();
+    header.fileSize_ = offset_;
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out_.flush();
+    if(!out_)
+        throw std::runtime_error("SnapshotWriter::finish: unable to write " + path_);
+}
+
+SnapshotHeader aux::makeSnapshotHeader(
+        SnapshotKind kind,
+        size_t levels,
+        size_t valueSize,
+        size_t size,
+        char delimeter)
+{
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic_, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version_ = SNAPSHOT_VERSION;
+    header.kind_ = kind;
+    header.levels_ = static_cast<uint32_t>(levels);
+    header.valueSize_ = static_cast<uint32_t>(valueSize);
+    header.size_ = size;
+    header.delimeter_ = delimeter;
+    return header;
+}
+
+const SnapshotHeader &aux::checkSnapshotHeader(
+        const MappedFile &file,
+        SnapshotKind kind,
+        size_t levels,
+        size_t valueSize)
+{
+    const SnapshotHeader *header = file.at<SnapshotHeader>(0);
+    if(nullptr == header || 0 != std::memcmp(header->magic_, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)))
+        throw std::runtime_error("checkSnapshotHeader: file is not a snapshot");
+    if(SNAPSHOT_VERSION != header->version_)
+        throw std::runtime_error("checkSnapshotHeader: unsupported version of snapshot");
+    if(static_cast<uint32_t>(kind) != header->kind_ || levels != header->levels_ || valueSize != header->valueSize_)
+        throw std::runtime_error("checkSnapshotHeader: snapshot is saved by another container");
+    if(file.size() != header->fileSize_)
+        throw std::runtime_error("checkSnapshotHeader: snapshot is truncated");
+    return *header;
+}
+
+std::vector<SnapshotDictionary> aux::readSnapshotDictionaries(
+        const MappedFile &file,
+        const SnapshotHeader &header)
+{
+    std::vector<SnapshotDictionary> res;
+    res.reserve(header.levels_);
+    uint64_t offset = header.dictionaries_;
+    for(size_t i = 0; i < header.levels_; ++i){
+        res.emplace_back(file, offset);
+        offset = res.back().end();
+    }
+    return res;
+}
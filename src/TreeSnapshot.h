@@ -0,0 +1,158 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+namespace aux {
+
+    /// Binary image of a container. All references inside of the image are offsets from the
+    /// beginning of the file, all sections are 8 bytes aligned, so the image is used in place
+    /// after mmap. Layout:
+    ///     SnapshotHeader
+    ///     dictionary of every level: uint64 count, uint64 offsets[count + 1] of subkeys in the blob,
+    ///         uint64 sorted[count] indexes of subkeys in lexicographical order, blob of subkeys
+    ///     data: nodes of SuffixTree (children before parents, see SnapshotChild) or dense arrays
+    ///         of StaticSuffixTree
+    enum SnapshotKind{
+        tree_SnapshotKind = 1,
+        static_SnapshotKind = 2
+    };
+
+    struct SnapshotHeader{
+        char magic_[8];
+        uint32_t version_;
+        uint32_t kind_;
+        uint32_t levels_;
+        uint32_t valueSize_;
+        uint64_t size_;            ///count of values
+        uint64_t dictionaries_;    ///offset of the dictionary of the root level
+        uint64_t data_;            ///offset of the root node or of the dense arrays
+        uint64_t fileSize_;
+        char delimeter_;
+        char reserved_[7];
+    };
+
+    /// entry of the inner node of SuffixTree: inner node is uint64 count followed by entries
+    /// sorted by index, leaf is uint64 count, uint64 indexes[count] and values[count]
+    struct SnapshotChild{
+        uint64_t index_;
+        uint64_t offset_;
+    };
+
+    /// read only mapping of the whole file
+    class MappedFile{
+    public:
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        const char *data()const noexcept{return data_;}
+        size_t size()const noexcept{return size_;}
+
+        /// pointer to count objects of T at offset or nullptr if they are out of the file
+        template<typename T>
+        const T *at(
+                uint64_t offset,
+                size_t count = 1)const noexcept
+        {
+            if(offset > size_ || count > (size_ - offset) / sizeof(T) || 0 != offset % alignof(T))
+                return nullptr;
+            return reinterpret_cast<const T *>(data_ + offset);
+        }
+
+    private:
+        const char *data_;
+        size_t size_;
+    };
+
+    /// dictionary of one level inside of the mapped image
+    class SnapshotDictionary{
+    public:
+        SnapshotDictionary();
+
+        /// throws std::runtime_error if the section doesn't fit into the file
+        SnapshotDictionary(
+                const MappedFile &file,
+                uint64_t offset);
+
+        size_t size()const noexcept{return count_;}
+
+        std::string_view key(size_t index)const noexcept
+        {
+            return std::string_view(blob_ + offsets_[index], offsets_[index + 1] - offsets_[index]);
+        }
+
+        /// binary search without allocations
+        bool find(
+                std::string_view key,
+                size_t &index)const noexcept;
+
+        /// offset of the next section
+        uint64_t end()const noexcept{return end_;}
+
+    private:
+        size_t count_;
+        const uint64_t *offsets_;
+        const uint64_t *sorted_;
+        const char *blob_;
+        uint64_t end_;
+    };
+
+    class SnapshotWriter{
+    public:
+        /// reserves space for the header, throws std::runtime_error if file can't be created
+        explicit SnapshotWriter(const std::string &path);
+
+        uint64_t offset()const noexcept{return offset_;}
+
+        void write(
+                const void *data,
+                size_t size);
+
+        template<typename T>
+        void writeValue(const T &val)
+        {
+            write(&val, sizeof(T));
+        }
+
+        /// pads file with zeros up to the multiple of 8
+        void align();
+
+        /// writes subkeys ordered by index, returns offset of the dictionary
+        uint64_t writeDictionary(const std::vector<std::string_view> &keys);
+
+        /// writes header and flushes file
+        void finish(SnapshotHeader &header);
+
+    private:
+        std::ofstream out_;
+        std::string path_;
+        uint64_t offset_;
+    };
+
+    SnapshotHeader makeSnapshotHeader(
+            SnapshotKind kind,
+            size_t levels,
+            size_t valueSize,
+            size_t size,
+            char delimeter);
+
+    /// checks magic, version, kind, count of levels, size of value and size of file,
+    /// throws std::runtime_error on mismatch
+    const SnapshotHeader &checkSnapshotHeader(
+            const MappedFile &file,
+            SnapshotKind kind,
+            size_t levels,
+            size_t valueSize);
+
+    std::vector<SnapshotDictionary> readSnapshotDictionaries(
+            const MappedFile &file,
+            const SnapshotHeader &header);
+
+}
@@ -33,6 +33,13 @@ double hptimer::HighPerfTimer::interval()const
 
 bool hptimer::setProcessAffinity(char cpuId)
 {
+    return setProcessAffinity(static_cast<int>(cpuId));
+}
+
+bool hptimer::setProcessAffinity(int cpuId)
+{
+    if(cpuId < 0 || cpuId >= CPU_SETSIZE)
+        return false;
     cpu_set_t mask;
     CPU_ZERO(&mask);
     CPU_SET(cpuId, &mask);
@@ -19,4 +19,6 @@ namespace hptimer{
     };
 
     bool setProcessAffinity(char cpuId);
+    /// returns false for cpuId out of [0, CPU_SETSIZE)
+    bool setProcessAffinity(int cpuId);
 }
\ No newline at end of file
@@ -91,6 +91,56 @@ BOOST_AUTO_TEST_SUITE( node_alloc_test )
         BOOST_REQUIRE(isDestroyed);
     }
 
+    BOOST_AUTO_TEST_CASE(slabReuseTest)
+    {
+        bool isDestroyed1 = false, isDestroyed2 = false;
+        suffix_tree::suffix_tree_impl::NodeAllocatorEx<DestroyCheck> alloc2Test(2);
+        DestroyCheck *obj1 = alloc2Test.create(isDestroyed1);
+        DestroyCheck *obj2 = alloc2Test.create(isDestroyed2);
+        BOOST_REQUIRE(2 == alloc2Test.allocated());
+        /// both nodes are placed into one chunk
+        BOOST_REQUIRE(obj1 + 1 == obj2);
+
+        alloc2Test.destroy(obj1);
+        BOOST_REQUIRE(isDestroyed1);
+        BOOST_REQUIRE(1 == alloc2Test.allocated());
+
+        /// released slot is reused by next allocation
+        DestroyCheck *obj3 = alloc2Test.create(isDestroyed1);
+        BOOST_REQUIRE(obj1 == obj3);
+
+        alloc2Test.destroy(obj3);
+        alloc2Test.destroy(obj2);
+        BOOST_REQUIRE(isDestroyed2);
+        alloc2Test.clear();
+        BOOST_REQUIRE(0 == alloc2Test.allocated());
+    }
+
+    BOOST_AUTO_TEST_CASE(slabAdoptTest)
+    {
+        bool isDestroyed1 = false, isDestroyed2 = false;
+        suffix_tree::suffix_tree_impl::NodeAllocatorEx<DestroyCheck> alloc2Test(2);
+        suffix_tree::suffix_tree_impl::NodeAllocatorEx<DestroyCheck> workerAlloc(4);
+        DestroyCheck *obj1 = alloc2Test.create(isDestroyed1);
+        DestroyCheck *obj2 = workerAlloc.create(isDestroyed2);
+
+        alloc2Test.adopt(workerAlloc);
+        BOOST_REQUIRE(2 == alloc2Test.allocated());
+        BOOST_REQUIRE(0 == workerAlloc.allocated());
+
+        /// node of adopted pool is released to the new owner
+        alloc2Test.destroy(obj2);
+        BOOST_REQUIRE(isDestroyed2);
+        BOOST_REQUIRE(1 == alloc2Test.allocated());
+        DestroyCheck *obj3 = alloc2Test.create(isDestroyed2);
+        BOOST_REQUIRE(obj2 == obj3);
+
+        alloc2Test.destroy(obj3);
+        alloc2Test.destroy(obj1);
+        BOOST_REQUIRE(isDestroyed1);
+        BOOST_REQUIRE(0 == alloc2Test.allocated());
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif
\ No newline at end of file
@@ -7,12 +7,18 @@
 #pragma GCC diagnostic pop
 
 #include "StaticSuffixTree.h"
+#include "FixedSuffixTree.h"
+#include "GrowableSuffixTree.h"
 #include "StaticContBuilder.h"
+#include "SuffixTreeTraits.h"
 #include "MemAllocHook.h"
 #include <iostream>
 #include <functional>
+#include <memory>
 #include <string>
 #include <map>
+#include <cstdio>
+#include <fstream>
 
 
 namespace{
@@ -265,6 +271,518 @@ BOOST_AUTO_TEST_SUITE( static_suffix_tree_test )
         BOOST_REQUIRE(99 == *cit);
     }
 
+    BOOST_AUTO_TEST_CASE (assignContainerTest)
+    {
+        StaticContBuilder builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef st_suffix_tree::StaticSuffixTree<StaticContBuilder, std::string, int> ContT;
+        ContT cont(builder);
+        ContT other(builder);
+        other.insert("aaa-bba-cca-dda", 1);
+
+        /// assignment keeps presence bitmap in the storage of the container
+        cont = other;
+        cont.insert("aab-bba-cca-dda", 2);
+        BOOST_REQUIRE(2 == cont.size());
+        BOOST_REQUIRE(1 == other.size());
+        BOOST_REQUIRE(other.end() == other.find("aab-bba-cca-dda"));
+        BOOST_REQUIRE(1 == *cont.find("aaa-bba-cca-dda"));
+    }
+
+    BOOST_AUTO_TEST_CASE (stringViewKeyTest)
+    {
+        StaticContBuilder builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        st_suffix_tree::StaticSuffixTree<StaticContBuilder, std::string, int> cont(builder);
+        /// keys are parts of the buffer, which is not zero terminated after the key
+        const char buffer[] = "aaa-bbb-ccc-dddaaa-bba-cca-dda";
+        auto it = cont.insert(std::string_view(buffer, 15), 777);
+        BOOST_REQUIRE(cont.end() != it);
+        it = cont.insert(buffer + 15, 15, 333);
+        BOOST_REQUIRE(cont.end() != it);
+        BOOST_REQUIRE(2 == cont.size());
+
+        BOOST_REQUIRE(777 == *cont.find(buffer, 15));
+        BOOST_REQUIRE(333 == *cont.find(std::string_view(buffer + 15, 15)));
+        BOOST_REQUIRE(cont.end() == cont.find(buffer, 11));
+        BOOST_REQUIRE(cont.end() == cont.find(buffer, 19));
+
+        cont.erase(std::string_view(buffer, 15));
+        BOOST_REQUIRE(1 == cont.size());
+    }
+    BOOST_AUTO_TEST_CASE (parsedKeyTest)
+    {
+        StaticContBuilder builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef st_suffix_tree::StaticSuffixTree<StaticContBuilder, std::string, int> ContT;
+        ContT cont(builder);
+        ContT::ParsedKeyT key = cont.builder().parseKey("aaa-bbb-ccc-ddd");
+        BOOST_REQUIRE(cont.builder().isValid(key));
+        ContT::ParsedKeyT unknownKey = cont.builder().parseKey("aaa-bbb-XXX-ddd");
+        BOOST_REQUIRE(!cont.builder().isValid(unknownKey));
+
+        BOOST_REQUIRE(cont.end() != cont.insert(key, 777));
+        BOOST_REQUIRE(cont.end() == cont.insert(unknownKey, 888));
+        BOOST_REQUIRE(1 == cont.size());
+        BOOST_REQUIRE(777 == *cont.find(key));
+        BOOST_REQUIRE(777 == *cont.find("aaa-bbb-ccc-ddd"));
+        BOOST_REQUIRE(cont.end() == cont.find(unknownKey));
+
+        cont.erase(key);
+        BOOST_REQUIRE(0 == cont.size());
+        BOOST_REQUIRE(cont.end() == cont.find(key));
+    }
+
+    BOOST_AUTO_TEST_CASE (exactSubkeyMatchTest)
+    {
+        /// subkeys sharing prefixes, including ones longer than 8 bytes
+        Key2IdxT lvl1{"a", "aa", "aab", "instrument", "instrument_1", "instrument_2", "instrumentation"};
+        StaticContBuilder builder(lvl1, prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        std::sort(lvl1.begin(), lvl1.end());
+        for(size_t i = 0; i < lvl1.size(); ++i){
+            StaticContBuilder::ParsedKeyT key;
+            BOOST_REQUIRE(builder.parseKey(lvl1[i] + "-bba-cca-dda", key));
+            BOOST_REQUIRE(i == key[0]);
+        }
+        StaticContBuilder::ParsedKeyT key;
+        BOOST_REQUIRE(!builder.parseKey("-bba-cca-dda", key));
+        BOOST_REQUIRE(!builder.parseKey("aaa-bba-cca-dda", key));
+        BOOST_REQUIRE(!builder.parseKey("instrument_3-bba-cca-dda", key));
+        BOOST_REQUIRE(!builder.parseKey("instrumen-bba-cca-dda", key));
+        BOOST_REQUIRE(!builder.parseKey("zzz-bba-cca-dda", key));
+        /// prefix of known subkey isn't accepted
+        BOOST_REQUIRE(!builder.parseKey("aaa-bb-cca-dda", key));
+        BOOST_REQUIRE(!builder.parseKey("aaa-bba-cca-ddaa", key));
+
+        Key2IdxT many;
+        for(size_t i = 0; i < 5000; ++i)
+            many.push_back("subkey" + std::to_string(i*7));
+        StaticContBuilder bigBuilder(many, prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        std::sort(many.begin(), many.end());
+        for(size_t i = 0; i < many.size(); ++i){
+            BOOST_REQUIRE(bigBuilder.parseKey(many[i] + "-bba-cca-dda", key));
+            BOOST_REQUIRE(i == key[0]);
+        }
+        BOOST_REQUIRE(!bigBuilder.parseKey("subkey1-bba-cca-dda", key));
+    }
+
+    BOOST_AUTO_TEST_CASE (traitsBuilder3LevelsTest)
+    {
+        typedef aux::SuffixTreeTraits<3, std::string, int> TraitsT;
+        TraitsT builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys());
+        typedef st_suffix_tree::StaticSuffixTree<TraitsT, std::string, int> ContT;
+        ContT cont(builder);
+        BOOST_REQUIRE(0 == cont.size());
+        BOOST_REQUIRE(cont.end() == cont.insert("aaa-bbb-ccc-ddd", 1));
+        BOOST_REQUIRE(cont.end() == cont.insert("aaa-bbb", 1));
+
+        BOOST_REQUIRE(cont.end() != cont.insert("aaa-bba-ccz", 1));
+        BOOST_REQUIRE(cont.end() != cont.insert("aaz-bbz-cca", 2));
+        BOOST_REQUIRE(cont.end() != cont.insert("aab-bba-cca", 3));
+        BOOST_REQUIRE(3 == cont.size());
+        BOOST_REQUIRE(2 == *cont.find("aaz-bbz-cca"));
+        BOOST_REQUIRE(cont.end() == cont.find("aaz-bbz-ccb"));
+
+        /// iteration follows the order of subkey indexes
+        std::vector<int> values;
+        for(auto it = cont.begin(); it != cont.end(); ++it)
+            values.push_back(*it);
+        BOOST_REQUIRE((std::vector<int>{1, 3, 2}) == values);
+
+        ContT copy(cont);
+        BOOST_REQUIRE(3 == copy.size());
+        BOOST_REQUIRE(3 == *copy.find("aab-bba-cca"));
+    }
+
+    BOOST_AUTO_TEST_CASE (traitsBuilder5LevelsTest)
+    {
+        Key2IdxT lvl5{"eea", "eeb", "eec"};
+        typedef aux::SuffixTreeTraits<5, std::string, int> TraitsT;
+        TraitsT builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys(), lvl5);
+        typedef st_suffix_tree::StaticSuffixTree<TraitsT, std::string, int> ContT;
+        ContT cont(builder);
+        std::map<std::string, int> expected;
+        int value = 0;
+        for(auto &k1: prepareLevel1Keys()){
+            for(auto &k5: lvl5){
+                std::string key = k1 + "-bbc-ccd-dde-" + k5;
+                BOOST_REQUIRE(cont.end() != cont.insert(key, value));
+                expected[key] = value++;
+            }
+        }
+        BOOST_REQUIRE(expected.size() == cont.size());
+        for(auto &val: expected)
+            BOOST_REQUIRE(val.second == *cont.find(val.first));
+        BOOST_REQUIRE(cont.end() == cont.find("aaa-bbc-ccd-dde-eed"));
+
+        ContT::ParsedKeyT key = cont.builder().parseKey("aaa-bbc-ccd-dde-eeb");
+        BOOST_REQUIRE(cont.end() != cont.erase(key));
+        BOOST_REQUIRE(expected.size() - 1 == cont.size());
+        BOOST_REQUIRE(cont.end() == cont.find(key));
+    }
+
+    BOOST_AUTO_TEST_CASE (presenceBitmapTest)
+    {
+        typedef st_suffix_tree::st_suffix_tree_impl::PresenceBitmap BitmapT;
+        BitmapT bitmap(100000);
+        BOOST_REQUIRE(BitmapT::NPOS == bitmap.first());
+        std::vector<size_t> positions{0, 63, 64, 4095, 4096, 50000, 99999};
+        for(auto pos: positions)
+            BOOST_REQUIRE(bitmap.set(pos));
+        BOOST_REQUIRE(!bitmap.set(64));
+        BOOST_REQUIRE(positions.size() == bitmap.count());
+
+        std::vector<size_t> found;
+        for(size_t pos = bitmap.first(); BitmapT::NPOS != pos; pos = bitmap.next(pos))
+            found.push_back(pos);
+        BOOST_REQUIRE(positions == found);
+
+        BOOST_REQUIRE(7 == bitmap.countRange(0, 100000));
+        BOOST_REQUIRE(2 == bitmap.countRange(63, 4095));
+        BOOST_REQUIRE(0 == bitmap.countRange(65, 4095));
+        BOOST_REQUIRE(1 == bitmap.countRange(99999, 100000));
+
+        BOOST_REQUIRE(bitmap.reset(4096));
+        BOOST_REQUIRE(!bitmap.reset(4096));
+        BOOST_REQUIRE(50000 == bitmap.next(4095));
+        BOOST_REQUIRE(3 == bitmap.countRange(4000, 100000));
+        bitmap.clear();
+        BOOST_REQUIRE(0 == bitmap.count());
+        BOOST_REQUIRE(BitmapT::NPOS == bitmap.first());
+
+        /// block counts follow interleaved updates
+        std::vector<bool> expected(bitmap.size());
+        size_t seed = 1;
+        for(size_t i = 0; i < 2000; ++i){
+            seed = seed*6364136223846793005ull + 1442695040888963407ull;
+            size_t pos = (seed >> 33) % bitmap.size();
+            if(0 == i % 3){
+                bitmap.reset(pos);
+                expected[pos] = false;
+            }else{
+                bitmap.set(pos);
+                expected[pos] = true;
+            }
+            size_t from = (seed >> 17) % bitmap.size();
+            size_t to = std::min(bitmap.size(), from + (seed >> 40) % 20000);
+            BOOST_REQUIRE(size_t(std::count(expected.begin() + from, expected.begin() + to, true)) == bitmap.countRange(from, to));
+        }
+
+        /// block counts are rebuilt from words
+        BitmapT restored;
+        restored.assign(bitmap.words(), bitmap.size());
+        for(size_t from = 0; from < restored.size(); from += 9999)
+            BOOST_REQUIRE(size_t(std::count(expected.begin() + from, expected.end(), true)) == restored.countRange(from, restored.size()));
+    }
+
+    BOOST_AUTO_TEST_CASE (sparseIterationAndCountTest)
+    {
+        StaticContBuilder builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef st_suffix_tree::StaticSuffixTree<StaticContBuilder, std::string, int> ContT;
+        ContT cont(builder);
+        BOOST_REQUIRE(cont.end() == cont.begin());
+        cont.insert("aab-bbz-ccz-ddz", 2);
+        cont.insert("aaa-bba-cca-dda", 1);
+        cont.insert("aaz-bbz-ccz-ddz", 3);
+
+        std::vector<int> values;
+        for(auto it = cont.begin(); it != cont.end(); ++it)
+            values.push_back(*it);
+        BOOST_REQUIRE((std::vector<int>{1, 2, 3}) == values);
+
+        auto &b = cont.builder();
+        BOOST_REQUIRE(3 == cont.count(b.parseKey("aaa-bba-cca-dda"), b.parseKey("aaz-bbz-ccz-ddz")));
+        BOOST_REQUIRE(2 == cont.count(b.parseKey("aab-bba-cca-dda"), b.parseKey("aaz-bbz-ccz-ddz")));
+        BOOST_REQUIRE(1 == cont.count(b.parseKey("aab-bba-cca-dda"), b.parseKey("aab-bbz-ccz-ddz")));
+        BOOST_REQUIRE(0 == cont.count(b.parseKey("aac-bba-cca-dda"), b.parseKey("aay-bbz-ccz-ddz")));
+
+        cont.erase("aab-bbz-ccz-ddz");
+        BOOST_REQUIRE(3 == *(++cont.begin()));
+        BOOST_REQUIRE(2 == cont.count(b.parseKey("aaa-bba-cca-dda"), b.parseKey("aaz-bbz-ccz-ddz")));
+        cont.clear();
+        BOOST_REQUIRE(cont.end() == cont.begin());
+    }
+
+    BOOST_AUTO_TEST_CASE (snapshotTest)
+    {
+        const std::string path = "staticSuffixTreeSnapshot.bin";
+        StaticContBuilder builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef st_suffix_tree::StaticSuffixTree<StaticContBuilder, std::string, int> ContT;
+        ContT cont(builder);
+        cont.insert("aab-bbz-ccz-ddz", 2);
+        cont.insert("aaa-bba-cca-dda", 1);
+        cont.insert("aaz-bbz-ccz-ddz", 3);
+        cont.save(path);
+
+        ContT loaded(builder);
+        loaded.insert("aac-bba-cca-dda", 4);
+        loaded.load(path);
+        BOOST_REQUIRE(3 == loaded.size());
+        BOOST_REQUIRE(loaded.end() == loaded.find("aac-bba-cca-dda"));
+        std::vector<int> values;
+        for(auto it = loaded.begin(); it != loaded.end(); ++it)
+            values.push_back(*it);
+        BOOST_REQUIRE((std::vector<int>{1, 2, 3}) == values);
+        BOOST_REQUIRE(2 == *loaded.find("aab-bbz-ccz-ddz"));
+
+        /// dictionaries of snapshot have to match builder
+        Key2IdxT lvl4 = prepareLevel4Keys();
+        lvl4.pop_back();
+        ContT other(StaticContBuilder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), lvl4));
+        BOOST_REQUIRE_THROW(other.load(path), std::runtime_error);
+
+        /// truncated image is rejected
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::app);
+            out << "x";
+        }
+        BOOST_REQUIRE_THROW(loaded.load(path), std::runtime_error);
+        BOOST_REQUIRE(3 == loaded.size());
+        std::remove(path.c_str());
+        BOOST_REQUIRE_THROW(loaded.load(path), std::runtime_error);
+    }
+
+    BOOST_AUTO_TEST_CASE (mappedStorageTest)
+    {
+        const std::string path = "staticSuffixTreeGrid.bin";
+        std::remove(path.c_str());
+        StaticContBuilder builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef st_suffix_tree::MappedFileStorage<int> StorageT;
+        typedef st_suffix_tree::StaticSuffixTree<StaticContBuilder, std::string, int, StorageT> ContT;
+        {
+            /// empty file and temporary file left by interrupted creation are replaced
+            std::ofstream(path, std::ios::binary);
+            std::ofstream(path + ".tmp", std::ios::binary) << "x";
+            ContT cont(builder, StorageT(path));
+            BOOST_REQUIRE(0 == cont.size());
+            BOOST_REQUIRE(!std::ifstream(path + ".tmp"));
+            cont.insert("aab-bbz-ccz-ddz", 2);
+            cont.insert("aaa-bba-cca-dda", 1);
+            cont.insert("aaz-bbz-ccz-ddz", 3);
+            cont.erase("aab-bbz-ccz-ddz");
+            cont.storage().sync();
+        }
+
+        /// content is restored from the file
+        ContT cont(builder, StorageT(path));
+        BOOST_REQUIRE(2 == cont.size());
+        BOOST_REQUIRE(cont.end() == cont.find("aab-bbz-ccz-ddz"));
+        std::vector<int> values;
+        for(auto it = cont.begin(); it != cont.end(); ++it)
+            values.push_back(*it);
+        BOOST_REQUIRE((std::vector<int>{1, 3}) == values);
+        BOOST_REQUIRE(2 == cont.count(builder.parseKey("aaa-bba-cca-dda"), builder.parseKey("aaz-bbz-ccz-ddz")));
+
+        /// snapshot is loaded into the mapped arrays
+        const std::string snapshot = "staticSuffixTreeGrid.snapshot";
+        st_suffix_tree::StaticSuffixTree<StaticContBuilder, std::string, int> heap(builder);
+        heap.insert("aac-bba-cca-dda", 4);
+        heap.save(snapshot);
+        cont.load(snapshot);
+        BOOST_REQUIRE(1 == cont.size());
+        BOOST_REQUIRE(4 == *cont.find("aac-bba-cca-dda"));
+        std::remove(snapshot.c_str());
+
+        /// file of other dictionaries is rejected
+        Key2IdxT lvl4 = prepareLevel4Keys();
+        lvl4.pop_back();
+        BOOST_REQUIRE_THROW(
+                ContT(StaticContBuilder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), lvl4), StorageT(path)),
+                std::runtime_error);
+        std::remove(path.c_str());
+    }
+
+    BOOST_AUTO_TEST_CASE (reservedStorageTest)
+    {
+        StaticContBuilder builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef st_suffix_tree::ReservedStorage<int> StorageT;
+        typedef st_suffix_tree::StaticSuffixTree<StaticContBuilder, std::string, int, StorageT> ContT;
+        ContT cont(builder);
+        const size_t pageSize = st_suffix_tree::st_suffix_tree_impl::ReservedMemory::pageSize();
+        BOOST_REQUIRE(26*26*26*26*sizeof(int) <= cont.storage().reserved());
+        BOOST_REQUIRE(0 == cont.storage().committed());
+
+        cont.insert("aaz-bbz-ccz-ddz", 3);
+        cont.insert("aaa-bba-cca-dda", 1);
+        cont.insert("aaa-bba-cca-ddb", 2);
+        BOOST_REQUIRE(3 == cont.size());
+        BOOST_REQUIRE(4*pageSize >= cont.storage().committed());
+        std::vector<int> values;
+        for(auto it = cont.begin(); it != cont.end(); ++it)
+            values.push_back(*it);
+        BOOST_REQUIRE((std::vector<int>{1, 2, 3}) == values);
+
+        cont.clear();
+        BOOST_REQUIRE(0 == cont.size());
+        BOOST_REQUIRE(0 == cont.storage().committed());
+        BOOST_REQUIRE(cont.end() == cont.begin());
+        cont.insert("aab-bba-cca-dda", 4);
+        BOOST_REQUIRE(4 == *cont.find("aab-bba-cca-dda"));
+        BOOST_REQUIRE(cont.end() == cont.find("aaa-bba-cca-dda"));
+
+        /// container with move-only storage is moved with its presence bitmap
+        ContT moved(std::move(cont));
+        BOOST_REQUIRE(1 == moved.size());
+        BOOST_REQUIRE(0 == cont.size());
+        BOOST_REQUIRE(4 == *moved.find("aab-bba-cca-dda"));
+        ContT assigned(builder);
+        assigned = std::move(moved);
+        BOOST_REQUIRE(1 == assigned.size());
+        BOOST_REQUIRE(4 == *assigned.find("aab-bba-cca-dda"));
+        assigned.insert("aac-bba-cca-dda", 5);
+        BOOST_REQUIRE(2 == assigned.count(builder.parseKey("aab-bba-cca-dda"), builder.parseKey("aac-bba-cca-dda")));
+    }
+
+    BOOST_AUTO_TEST_CASE (sliceTest)
+    {
+        using st_suffix_tree::st_suffix_tree_impl::ANY_INDEX;
+        StaticContBuilder builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef st_suffix_tree::StaticSuffixTree<StaticContBuilder, std::string, int> ContT;
+        ContT cont(builder);
+        /// value is index of the slot
+        for(int index = 0; index < 26*26*26*26; index += 7)
+            cont.insert(ContT::ParsedKeyT{{size_t(index/26/26/26), size_t(index/26/26%26), size_t(index/26%26), size_t(index%26)}}, index);
+
+        std::vector<ContT::ParsedKeyT> patterns{
+                {{ANY_INDEX, ANY_INDEX, 3, ANY_INDEX}},
+                {{ANY_INDEX, ANY_INDEX, ANY_INDEX, 5}},
+                {{2, ANY_INDEX, 4, ANY_INDEX}},
+                {{ANY_INDEX, 1, ANY_INDEX, 25}},
+                {{ANY_INDEX, ANY_INDEX, ANY_INDEX, ANY_INDEX}},
+                {{1, 2, 3, 4}},
+                {{1, 2, 3, 5}}};
+        for(auto &pattern: patterns){
+            std::vector<int> expected;
+            for(auto it = cont.begin(); it != cont.end(); ++it){
+                size_t key[] = {size_t(*it/26/26/26), size_t(*it/26/26%26), size_t(*it/26%26), size_t(*it%26)};
+                bool match = true;
+                for(size_t lvl = 0; lvl < 4; ++lvl)
+                    match = match && (ANY_INDEX == pattern[lvl] || pattern[lvl] == key[lvl]);
+                if(match)
+                    expected.push_back(*it);
+            }
+            std::vector<int> values;
+            size_t visited = cont.slice(pattern, [&values](const ContT::ParsedKeyT &key, int val)
+            {
+                BOOST_REQUIRE(int(((key[0]*26 + key[1])*26 + key[2])*26 + key[3]) == val);
+                values.push_back(val);
+            });
+            BOOST_REQUIRE(expected.size() == visited);
+            BOOST_REQUIRE(expected == values);
+            values.clear();
+            BOOST_REQUIRE(expected.size() == cont.gather(pattern, values));
+            BOOST_REQUIRE(expected == values);
+        }
+        BOOST_REQUIRE(0 == cont.slice(ContT::ParsedKeyT{{26, ANY_INDEX, 0, 0}}, [](const ContT::ParsedKeyT &, int){}));
+    }
+
+    BOOST_AUTO_TEST_CASE (growableDimsTest)
+    {
+        typedef aux::SuffixTreeTraits<4, std::string, int> TraitsT;
+        typedef st_suffix_tree::GrowableSuffixTree<TraitsT, int> ContT;
+        TraitsT builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+
+        /// new subkey takes reserved slot
+        ContT reserved(builder);
+        BOOST_REQUIRE(39 == reserved.capacity(TraitsT::SuffixLevel::root_Suffix));
+        reserved.insert("aaa-bba-cca-dda", 1);
+        reserved.insert("new-bba-cca-dda", 2);
+        BOOST_REQUIRE(!reserved.migrating());
+        BOOST_REQUIRE(39 == reserved.capacity(TraitsT::SuffixLevel::root_Suffix));
+        BOOST_REQUIRE(2 == *reserved.find("new-bba-cca-dda"));
+
+        /// level without headroom is grown, blocks are migrated incrementally
+        ContT cont(builder, 0);
+        std::map<std::string, int> expected;
+        int count = 0;
+        for(auto &k1: prepareLevel1Keys()){
+            for(auto &k4: prepareLevel4Keys()){
+                std::string key = k1 + "-bbc-ccd-" + k4;
+                cont.insert(key, count);
+                expected[key] = count++;
+            }
+        }
+        BOOST_REQUIRE(26 == cont.capacity(TraitsT::SuffixLevel::leaf_Suffix));
+        cont.insert("aab-bbc-ccd-new", count);
+        expected["aab-bbc-ccd-new"] = count++;
+        BOOST_REQUIRE(cont.migrating());
+        BOOST_REQUIRE(52 == cont.capacity(TraitsT::SuffixLevel::leaf_Suffix));
+        BOOST_REQUIRE(26 == *cont.find("aab-bbc-ccd-dda"));
+        BOOST_REQUIRE(cont.migrating());
+        cont.erase("aaz-bbc-ccd-ddz");
+        expected.erase("aaz-bbc-ccd-ddz");
+        BOOST_REQUIRE(expected.size() == cont.size());
+        for(auto &val: expected)
+            BOOST_REQUIRE(val.second == *cont.find(val.first));
+
+        /// readers don't migrate blocks and see values of the old grid in the order of keys
+        auto expectedIt = expected.begin();
+        for(auto it = cont.begin(); it != cont.end(); ++it, ++expectedIt)
+            BOOST_REQUIRE(expectedIt->second == *it);
+        BOOST_REQUIRE(expected.end() == expectedIt);
+        BOOST_REQUIRE(26 == cont.count(builder.parseKey("aab-bbc-ccd-dda"), builder.parseKey("aab-bbc-ccd-ddz")));
+        BOOST_REQUIRE(cont.migrating());
+
+        /// explicit reservation and migration driven by the owner
+        cont.reserve(ContT::CapacitiesT{{26, 26, 30, 52}});
+        BOOST_REQUIRE(cont.migrating());
+        while(!cont.migrate(1))
+            BOOST_REQUIRE(expected.size() == cont.size());
+        size_t visited = 0;
+        for(auto it = cont.begin(); it != cont.end(); ++it, ++visited)
+            BOOST_REQUIRE(0 <= *it && count > *it);
+        BOOST_REQUIRE(expected.size() == visited);
+        BOOST_REQUIRE(2 == cont.count(builder.parseKey("aab-bbc-ccd-dda"), builder.parseKey("aab-bbc-ccd-ddb")));
+    }
+
+    BOOST_AUTO_TEST_CASE (fixedDimsTest)
+    {
+        typedef st_suffix_tree::FixedSuffixTree<st_suffix_tree::Dims<26, 26, 26, 26>, int> ContT;
+        static_assert(26*26*26*26 == ContT::capacity());
+        static_assert(26*26*26 + 2*26 + 3 == ContT::indexOf<1, 0, 2, 3>());
+
+        auto cont = std::make_unique<ContT>();
+        BOOST_REQUIRE(0 == cont->size());
+        BOOST_REQUIRE(cont->end() == cont->begin());
+        BOOST_REQUIRE(cont->end() == cont->insert(ContT::ParsedKeyT{{26, 0, 0, 0}}, 1));
+
+        BOOST_REQUIRE((cont->end() != cont->insertAt<25, 25, 25, 25>(3)));
+        BOOST_REQUIRE(cont->end() != cont->insert(ContT::ParsedKeyT{{1, 0, 2, 3}}, 2));
+        BOOST_REQUIRE((cont->end() != cont->insertAt<0, 0, 0, 0>(1)));
+        BOOST_REQUIRE(3 == cont->size());
+        BOOST_REQUIRE((2 == *cont->findAt<1, 0, 2, 3>()));
+        BOOST_REQUIRE(cont->end() == cont->find(ContT::ParsedKeyT{{1, 0, 2, 4}}));
+
+        std::vector<int> values;
+        for(auto it = cont->begin(); it != cont->end(); ++it)
+            values.push_back(*it);
+        BOOST_REQUIRE((std::vector<int>{1, 2, 3}) == values);
+
+        BOOST_REQUIRE(3 == *cont->erase(ContT::ParsedKeyT{{1, 0, 2, 3}}));
+        BOOST_REQUIRE(2 == cont->size());
+        cont->clear();
+        BOOST_REQUIRE(cont->end() == cont->begin());
+    }
+
+    BOOST_AUTO_TEST_CASE (fixedPow2DimsTest)
+    {
+        typedef st_suffix_tree::FixedSuffixTree<st_suffix_tree::Pow2Dims<3, 26, 5>, int> ContT;
+        static_assert(4*32*8 == ContT::capacity());
+        static_assert(2*32*8 + 25*8 + 4 == ContT::indexOf<2, 25, 4>());
+
+        auto cont = std::make_unique<ContT>();
+        /// padding slots are not valid keys
+        BOOST_REQUIRE(cont->end() == cont->insert(ContT::ParsedKeyT{{3, 0, 0}}, 1));
+        BOOST_REQUIRE(cont->end() == cont->insert(ContT::ParsedKeyT{{0, 0, 5}}, 1));
+        for(size_t i = 0; i < 3; ++i)
+            for(size_t j = 0; j < 26; ++j)
+                for(size_t k = 0; k < 5; ++k)
+                    cont->insert({i, j, k}, static_cast<int>(i*1000 + j*10 + k));
+        BOOST_REQUIRE(3*26*5 == cont->size());
+        BOOST_REQUIRE((2254 == *(cont->findAt<2, 25, 4>())));
+        size_t count = 0;
+        for(auto it = cont->begin(); it != cont->end(); ++it)
+            ++count;
+        BOOST_REQUIRE(cont->size() == count);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif
\ No newline at end of file
@@ -12,6 +12,11 @@
 
 #include "SuffixTree.h"
 #include "SuffixTreeTraits.h"
+#include "HybridSuffixTree.h"
+#include "ConcurrentSuffixTree.h"
+#include "ShardedSuffixTree.h"
+#include "TreeReaper.h"
+#include "MappedSuffixTree.h"
 #include "hpUtils.h"
 #include "MemAllocHook.h"
 #include <cassert>
@@ -19,6 +24,9 @@
 #include <map>
 #include <iomanip>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <cstdio>
 
 namespace{
     typedef std::vector<std::string> GeneratedKeyT;
@@ -410,6 +418,781 @@ BOOST_AUTO_TEST_SUITE( suffix_tree_nlevel_test )
         assert(cont.end() == cont.find("aaa-bbb-cca-ddd"));
     }
 
+    BOOST_AUTO_TEST_CASE(childNodesModesTest)
+    {
+        typedef suffix_tree::suffix_tree_impl::ChildNodes<int> ChildNodesT;
+        const size_t capacity = 1000;
+        std::vector<int> vals(capacity, 0);
+        ChildNodesT nodes;
+        assert(nodes.empty());
+        assert(suffix_tree::suffix_tree_impl::INVALID_INDEX == nodes.first());
+
+        /// sorted array -> bitmap -> dense array
+        for(size_t i = 0; i < capacity; i += 2){
+            nodes.insert(i, &vals[i], capacity);
+            assert(&vals[i] == nodes.find(i));
+            assert(nullptr == nodes.find(i + 1));
+        }
+        assert(capacity/2 == nodes.size());
+        assert(0 == nodes.first());
+        assert(2 == nodes.next(0));
+        assert(suffix_tree::suffix_tree_impl::INVALID_INDEX == nodes.next(capacity - 2));
+
+        /// dense array -> bitmap -> sorted array
+        for(size_t i = 0; i < capacity - 2; i += 2){
+            assert(&vals[i] == nodes.erase(i));
+            assert(nullptr == nodes.erase(i));
+            assert(nullptr == nodes.find(i));
+            assert(&vals[i + 2] == nodes.find(i + 2));
+            assert(i + 2 == nodes.first());
+        }
+        assert(1 == nodes.size());
+        size_t count = 0;
+        nodes.forEach([&](size_t index, int *val){
+            assert(capacity - 2 == index);
+            assert(&vals[index] == val);
+            ++count;
+        });
+        assert(1 == count);
+    }
+
+    BOOST_AUTO_TEST_CASE(eraseAllKeysTest_4Nodes)
+    {
+        aux::SuffixTreeTraits<4, std::string, int> builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        suffix_tree::SuffixTree cont(builder);
+        char value[] = "aaa-bba-cca-dda";
+        int count = 0;
+        for(size_t i = 0; i < 26; ++i){
+            value[2] = 'a' + i;
+            for(size_t j = 0; j < 26; ++j){
+                value[6] = 'a' + j;
+                value[10] = 'a' + (i + j) % 26;
+                cont.insert(value, ++count);
+            }
+        }
+        assert(26*26 == cont.size());
+        assert(cont.end() == cont.find("aaa-bba-ccb-dda"));
+        assert(26*26 == cont.size());
+
+        count = 0;
+        for(size_t i = 0; i < 26; ++i){
+            value[2] = 'a' + i;
+            for(size_t j = 0; j < 26; ++j){
+                value[6] = 'a' + j;
+                value[10] = 'a' + (i + j) % 26;
+                auto it = cont.find(value);
+                assert(cont.end() != it);
+                assert(++count == *it);
+                cont.erase(value);
+                assert(cont.end() == cont.find(value));
+            }
+        }
+        assert(0 == cont.size());
+        assert(cont.end() == cont.begin());
+
+        auto it = cont.insert("aaa-bbb-ccc-ddd", 777);
+        assert(cont.end() != it);
+        assert(cont.begin() == it);
+        assert(1 == cont.size());
+    }
+    BOOST_AUTO_TEST_CASE(iterateTest_4Nodes)
+    {
+        aux::SuffixTreeTraits<4, std::string, int> builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        suffix_tree::SuffixTree cont(builder);
+        char value[] = "aaa-bba-cca-dda";
+        int sum = 0;
+        for(size_t i = 0; i < 26; i += 3){
+            value[2] = 'a' + i;
+            for(size_t j = 0; j < 26; j += 2){
+                value[6] = 'a' + j;
+                for(size_t k = 0; k < 26; k += 5){
+                    value[14] = 'a' + k;
+                    int val = static_cast<int>(i*10000 + j*100 + k);
+                    cont.insert(value, val);
+                    sum += val;
+                }
+            }
+        }
+        assert(9*13*6 == cont.size());
+
+        /// values are visited in the key order by prefix and postfix increments
+        size_t count = 0;
+        int visitedSum = 0;
+        int prevVal = -1;
+        for(auto it = cont.begin(); it != cont.end(); ++it){
+            assert(prevVal < *it);
+            prevVal = *it;
+            visitedSum += *it;
+            ++count;
+        }
+        assert(cont.size() == count);
+        assert(sum == visitedSum);
+
+        count = 0;
+        auto it = cont.begin();
+        while(cont.end() != it){
+            auto prevIt = it++;
+            assert(prevIt != it);
+            ++count;
+        }
+        assert(cont.size() == count);
+
+        /// erase every second value while iterating
+        count = 0;
+        it = cont.begin();
+        while(cont.end() != it){
+            it = cont.erase(it);
+            if(cont.end() != it)
+                ++it;
+            ++count;
+        }
+        assert(9*13*6/2 == cont.size());
+        assert(cont.size() == count);
+        count = 0;
+        for(auto it = cont.begin(); it != cont.end(); ++it)
+            ++count;
+        assert(cont.size() == count);
+    }
+    BOOST_AUTO_TEST_CASE(stringViewKeyTest_4Nodes)
+    {
+        aux::SuffixTreeTraits<4, std::string, int> builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        suffix_tree::SuffixTree cont(builder);
+        /// keys are parts of the buffer, which is not zero terminated after the key
+        const char buffer[] = "aaa-bbb-ccc-dddaaa-bba-cca-dda";
+        auto it = cont.insert(std::string_view(buffer, 15), 777);
+        assert(cont.end() != it);
+        it = cont.insert(buffer + 15, 15, 333);
+        assert(cont.end() != it);
+        assert(2 == cont.size());
+
+        assert(cont.end() != cont.find(std::string_view("aaa-bbb-ccc-ddd")));
+        assert(777 == *cont.find(buffer, 15));
+        assert(333 == *cont.find(std::string_view(buffer + 15, 15)));
+        assert(333 == *cont.find(std::string("aaa-bba-cca-dda")));
+        assert(cont.end() == cont.find(buffer, 14));
+        assert(cont.end() == cont.find(buffer, 11));
+        assert(cont.end() == cont.find(buffer, 19));
+
+        cont.erase(buffer, 15);
+        assert(1 == cont.size());
+        assert(cont.end() == cont.find(buffer, 15));
+    }
+    BOOST_AUTO_TEST_CASE(parsedKeyTest_4Nodes)
+    {
+        aux::SuffixTreeTraits<4, std::string, int> builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef suffix_tree::SuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        ContT cont(builder);
+        ContT::ParsedKeyT key = cont.traits().parseKey("aaa-bbb-ccc-ddd");
+        assert(cont.traits().isValid(key));
+        ContT::ParsedKeyT unknownKey = cont.traits().parseKey("aaa-bbb-XXX-ddd");
+        assert(!cont.traits().isValid(unknownKey));
+
+        auto it = cont.insert(key, 777);
+        assert(cont.end() != it);
+        assert(1 == cont.size());
+        assert(cont.end() == cont.insert(unknownKey, 888));
+        assert(1 == cont.size());
+
+        assert(777 == *cont.find(key));
+        assert(777 == *cont.find("aaa-bbb-ccc-ddd"));
+        assert(cont.end() == cont.find(unknownKey));
+        cont.insert("aaa-bbb-ccc-ddd", 999);
+        assert(999 == *cont.find(key));
+
+        assert(cont.end() == cont.erase(unknownKey));
+        cont.erase(key);
+        assert(0 == cont.size());
+        assert(cont.end() == cont.find(key));
+    }
+
+    BOOST_AUTO_TEST_CASE(batchTest_4Nodes)
+    {
+        aux::SuffixTreeTraits<4, std::string, int> builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef suffix_tree::SuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        ContT cont(builder);
+
+        std::vector<std::string> strKeys;
+        for(auto &k1: prepareLevel1Keys())
+            for(auto &k3: prepareLevel3Keys())
+                strKeys.push_back(k1 + "-bbc-" + k3 + "-ddd");
+        /// malformed key and duplicate key
+        strKeys.push_back("aaa-bbc-ddd");
+        strKeys.push_back("aab-bbc-cca-ddd");
+
+        std::vector<ContT::KeyViewT> keys(std::begin(strKeys), std::end(strKeys));
+        std::vector<int> values(keys.size());
+        for(size_t i = 0; i < values.size(); ++i)
+            values[i] = static_cast<int>(i);
+        std::vector<ContT::Iterator> results(keys.size(), cont.end());
+
+        cont.insert_batch(keys.data(), values.data(), keys.size(), results.data());
+        assert(26*26 == cont.size());
+        assert(cont.end() == results[keys.size() - 2]);
+        assert(cont.end() != results[26]);
+        assert(static_cast<int>(keys.size() - 1) == *results[26]);
+
+        std::vector<ContT::Iterator> found(keys.size(), cont.end());
+        cont.find_batch(keys.data(), keys.size(), found.data());
+        for(size_t i = 0; i < keys.size(); ++i)
+            assert(found[i] == cont.find(keys[i]));
+
+        cont.erase("aaa-bbc-cca-ddd");
+        std::vector<ContT::ParsedKeyT> parsedKeys;
+        for(auto &k: keys)
+            parsedKeys.push_back(cont.traits().parseKey(k));
+        cont.find_batch(parsedKeys.data(), parsedKeys.size(), found.data());
+        assert(cont.end() == found[0]);
+        for(size_t i = 1; i < keys.size(); ++i)
+            assert(found[i] == cont.find(keys[i]));
+    }
+
+    BOOST_AUTO_TEST_CASE(keyTokenizerTest)
+    {
+        std::string key;
+        size_t positions[8];
+        size_t expected[8];
+        for(size_t length = 0; length < 100; ++length){
+            key.assign(length, 'a');
+            /// delimiters at chunk borders and in the tail
+            for(size_t pos = 0; pos < length; pos += 1 + pos % 15)
+                key[pos] = '-';
+            for(size_t maxCount = 0; maxCount <= 8; maxCount += 4){
+                size_t count = aux::findDelimiters(key.data(), key.length(), '-', positions, maxCount);
+                size_t expectedCount = aux::findDelimitersScalar(key.data(), key.length(), '-', expected, maxCount);
+                assert(expectedCount == count);
+                assert(count <= maxCount + 1);
+                for(size_t i = 0; i < std::min(count, maxCount); ++i)
+                    assert(expected[i] == positions[i]);
+            }
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(perfectHashIndexTest)
+    {
+        aux::StringArena arena(32, 1024, 2.0, std::numeric_limits<int>::max());
+        aux::Key2IndexT keys;
+        for(size_t i = 0; i < 20000; ++i){
+            std::string key = "key" + std::to_string(i*7919);
+            keys[arena.allocate(key)] = i;
+        }
+        aux::PerfectHashIndex index;
+        assert(index.build(keys));
+        assert(index.built());
+        assert(keys.size() == index.size());
+        for(auto &key: keys){
+            size_t found = suffix_tree::suffix_tree_impl::INVALID_INDEX;
+            assert(index.find(key.first, found));
+            assert(key.second == found);
+        }
+        size_t found = 0;
+        assert(!index.find("key1", found));
+        assert(!index.find("", found));
+
+        aux::PerfectHashIndex emptyIndex;
+        assert(emptyIndex.build(aux::Key2IndexT()));
+        assert(!emptyIndex.find("key0", found));
+    }
+
+    BOOST_AUTO_TEST_CASE(flatKeyIndexTest)
+    {
+        aux::StringArena arena(32, 1024, 2.0, std::numeric_limits<int>::max());
+        aux::FlatKeyIndex keys;
+        assert(keys.empty());
+        assert(keys.end() == keys.find("key0"));
+        assert(keys.begin() == keys.end());
+        /// incremental inserts go through several rehashes
+        for(size_t i = 0; i < 5000; ++i){
+            std::string key = std::to_string(i);
+            keys[arena.allocate(key)] = i;
+        }
+        assert(5000 == keys.size());
+        for(size_t i = 0; i < 5000; ++i){
+            auto it = keys.find(std::to_string(i));
+            assert(keys.end() != it);
+            assert(i == it->second);
+        }
+        assert(keys.end() == keys.find("5000"));
+        assert(keys.end() == keys.find(""));
+
+        keys["0"] = 777;
+        assert(5000 == keys.size());
+        assert(777 == keys.find("0")->second);
+
+        size_t count = 0;
+        size_t sum = 0;
+        for(auto &val: keys){
+            ++count;
+            sum += val.second;
+        }
+        assert(5000 == count);
+        assert(4999*5000/2 + 777 == sum);
+
+        aux::FlatKeyIndex copy(keys);
+        assert(5000 == copy.size());
+        assert(42 == copy.find("42")->second);
+    }
+
+    BOOST_AUTO_TEST_CASE(shortKeyIndexTest)
+    {
+        aux::ShortKeyIndex keys;
+        size_t index = 0;
+        assert(!keys.find("", index));
+        std::string key;
+        for(size_t i = 0; i <= aux::ShortKeyIndex::MAX_LENGTH; ++i){
+            keys.insert(key, i);
+            key += 'a';
+        }
+        /// zero padding doesn't make keys equal
+        keys.insert(std::string_view("a\0", 2), 100);
+        assert(aux::ShortKeyIndex::MAX_LENGTH + 2 == keys.size());
+
+        key.clear();
+        for(size_t i = 0; i <= aux::ShortKeyIndex::MAX_LENGTH; ++i){
+            assert(keys.find(key, index));
+            assert(i == index);
+            key += 'a';
+        }
+        assert(keys.find(std::string_view("a\0", 2), index));
+        assert(100 == index);
+        assert(!keys.find("b", index));
+        assert(!keys.find(std::string_view("a\0\0", 3), index));
+    }
+
+    BOOST_AUTO_TEST_CASE(longSubkeysTest_2Nodes)
+    {
+        aux::Key2IdxT lvl1{"a", "exchange_code_long", "xxxxxxxxxxxxxxx", "xxxxxxxxxxxxxxxx"};
+        aux::Key2IdxT lvl2{"usd", "eur", "tenor_name_longer_than_16"};
+        typedef aux::SuffixTreeTraits<2, std::string, int> TraitsT;
+        TraitsT builder(lvl1, lvl2);
+        /// short keys mode of the leaf level, root level uses the general index
+        builder.enableShortKeys(TraitsT::SuffixLevel::leaf_Suffix);
+        for(bool frozen: {false, true}){
+            if(frozen)
+                builder.freeze();
+            for(size_t i = 0; i < lvl1.size(); ++i){
+                for(size_t j = 0; j < lvl2.size(); ++j){
+                    auto key = builder.parseKey(lvl1[i] + "-" + lvl2[j]);
+                    assert(i == key[0]);
+                    assert(j == key[1]);
+                }
+            }
+            assert(!builder.isValid(builder.parseKey("xxxxxxxxxxxxxx-usd")));
+            assert(!builder.isValid(builder.parseKey("xxxxxxxxxxxxxxxxx-usd")));
+        }
+        TraitsT::ParsedKeyT key;
+        assert(builder.parseNewKey("b-tenor_name_longer_than_17", key));
+        assert(4 == key[0]);
+        assert(3 == key[1]);
+        assert(key == builder.parseKey("b-tenor_name_longer_than_17"));
+        /// new short subkey of the unfrozen level is found by the short keys index
+        assert(builder.parseNewKey("c-jpy", key));
+        assert(4 == key[1]);
+        assert(key == builder.parseKey("c-jpy"));
+        TraitsT copy(builder);
+        assert(key == copy.parseKey("c-jpy"));
+        assert(!copy.isValid(copy.parseKey("c-gbp")));
+    }
+
+    BOOST_AUTO_TEST_CASE(frozenTraitsTest_4Nodes)
+    {
+        aux::SuffixTreeTraits<4, std::string, int> builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef aux::SuffixTreeTraits<4, std::string, int>::ParsedKeyT ParsedKeyT;
+        ParsedKeyT expected = builder.parseKey("aaz-bbc-cca-ddy");
+        assert(builder.isValid(expected));
+        assert(!builder.frozen());
+
+        bool built = builder.freeze();
+        assert(built && builder.frozen());
+        assert(expected == builder.parseKey("aaz-bbc-cca-ddy"));
+        ParsedKeyT res;
+        assert(!builder.parseKey("aaz-bbc-XXX-ddy", res));
+
+        /// copy keeps dictionaries frozen
+        aux::SuffixTreeTraits<4, std::string, int> copy(builder);
+        assert(copy.frozen());
+        assert(expected == copy.parseKey("aaz-bbc-cca-ddy"));
+
+        /// new subkey drops perfect hash of its level
+        assert(builder.parseNewKey("aaz-bbc-XXX-ddy", res));
+        assert(!builder.frozen());
+        assert(26 == res[2]);
+        assert(res == builder.parseKey("aaz-bbc-XXX-ddy"));
+        assert(expected == builder.parseKey("aaz-bbc-cca-ddy"));
+        builder.freeze();
+        assert(res == builder.parseKey("aaz-bbc-XXX-ddy"));
+    }
+
+    BOOST_AUTO_TEST_CASE(hybridTest_4Nodes)
+    {
+        typedef aux::SuffixTreeTraits<4, std::string, int> KeyTraitsT;
+        typedef suffix_tree::HybridSuffixTree<4, std::string, int> ContT;
+        KeyTraitsT keys(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        ContT cont((ContT::TraitsT(keys)));
+        suffix_tree::SuffixTree<KeyTraitsT> expected(keys);
+
+        for(auto &k3: prepareLevel3Keys()){
+            for(auto &k4: {"dda", "ddm", "ddz"}){
+                std::string key = std::string("aab-bbc-") + k3 + "-" + k4;
+                assert(cont.end() != cont.insert(key, static_cast<int>(expected.size())));
+                expected.insert(key, static_cast<int>(expected.size()));
+            }
+        }
+        assert(cont.end() != cont.insert("aaa-bbz-ccz-ddz", 1000));
+        expected.insert("aaa-bbz-ccz-ddz", 1000);
+        assert(expected.size() == cont.size());
+
+        /// same order of values as in the pointer tree
+        auto expectedIt = expected.begin();
+        for(auto it = cont.begin(); it != cont.end(); ++it, ++expectedIt)
+            assert(*expectedIt == *it);
+        assert(expected.end() == expectedIt);
+
+        assert(1000 == *cont.find("aaa-bbz-ccz-ddz"));
+        assert(cont.end() == cont.find("aaa-bbz-ccz-ddy"));
+        ContT::ParsedKeyT key = cont.traits().parseKey("aab-bbc-ccb-ddm");
+        assert(cont.traits().isValid(key));
+        assert(4 == *cont.find(key));
+        assert("-aab-bbc-ccb-ddm" == cont.traits().assembleKey(key));
+
+        /// new subkeys are accepted at upper levels only
+        assert(cont.end() != cont.insert("new-bbc-cca-dda", 1));
+        assert(cont.end() == cont.insert("aab-bbc-new-dda", 1));
+        assert(cont.end() == cont.insert("aab-bbc-cca-new", 1));
+        /// rejected keys don't add subkeys to any dictionary
+        size_t rootCount = cont.traits().keyTraits().suffixCount(KeyTraitsT::SuffixLevel::root_Suffix);
+        size_t denseCount = cont.traits().keyTraits().suffixCount(KeyTraitsT::SuffixLevel::level2_Suffix);
+        assert(cont.end() == cont.insert("rej-bbc-XXX-dda", 1));
+        assert(cont.end() == cont.insert("rej-bbc-cca", 1));
+        assert(rootCount == cont.traits().keyTraits().suffixCount(KeyTraitsT::SuffixLevel::root_Suffix));
+        assert(denseCount == cont.traits().keyTraits().suffixCount(KeyTraitsT::SuffixLevel::level2_Suffix));
+
+        cont.erase("aaa-bbz-ccz-ddz");
+        cont.erase("new-bbc-cca-dda");
+        assert(expected.size() - 1 == cont.size());
+        ContT copy(cont);
+        assert(copy.size() == cont.size());
+        assert(4 == *copy.find(key));
+    }
+
+    BOOST_AUTO_TEST_CASE(hybridTest_3Nodes)
+    {
+        typedef suffix_tree::HybridSuffixTree<3, std::string, int> ContT;
+        aux::SuffixTreeTraits<3, std::string, int> keys(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys());
+        ContT cont((ContT::TraitsT(keys)));
+        assert(cont.end() != cont.insert("aaa-bba-cca", 1));
+        assert(cont.end() != cont.insert("aaa-bbz-ccz", 2));
+        assert(2 == cont.size());
+        assert(2 == *cont.find("aaa-bbz-ccz"));
+        assert(cont.end() == cont.find("aab-bbz-ccz"));
+        assert(cont.end() == cont.insert("aaa-bbz", 3));
+    }
+
+    BOOST_AUTO_TEST_CASE(concurrentTreeTest_4Nodes)
+    {
+        typedef suffix_tree::ConcurrentSuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        ContT cont(ContT::TraitsT(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys()));
+        ContT::Reader reader(cont);
+        int val = 0;
+        assert(cont.insert("aaa-bba-cca-dda", 1));
+        assert(!cont.insert("aaa-bba-cca-dda", 2));
+        assert(cont.insert("aaa-bbb-cca-ddz", 3));
+        assert(!cont.insert("aaa-bbb-cca-dd?", 4));
+        assert(!cont.insert("aaa-bbb-cca", 4));
+        assert(2 == cont.size());
+        assert(reader.find("aaa-bba-cca-dda", val) && 2 == val);
+        assert(!reader.find("aaa-bba-cca-ddb", val));
+        assert(cont.erase("aaa-bba-cca-dda"));
+        assert(!cont.erase("aaa-bba-cca-dda"));
+        assert(!reader.find("aaa-bba-cca-dda", val));
+        assert(cont.find("aaa-bbb-cca-ddz", val) && 3 == val);
+        cont.clear();
+        assert(0 == cont.size());
+        assert(!reader.find("aaa-bbb-cca-ddz", val));
+        assert(cont.insert("aaa-bbb-cca-ddz", 5));
+        assert(reader.find("aaa-bbb-cca-ddz", val) && 5 == val);
+    }
+
+    BOOST_AUTO_TEST_CASE(concurrentReadersTest_4Nodes)
+    {
+        typedef suffix_tree::ConcurrentSuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        ContT cont(ContT::TraitsT(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys()));
+        std::vector<ContT::ParsedKeyT> keys;
+        for(auto &k2: prepareLevel2Keys())
+            for(auto &k4: prepareLevel4Keys())
+                keys.push_back(cont.traits().parseKey("aab-" + k2 + "-ccc-" + k4));
+
+        std::atomic<bool> stop(false);
+        std::atomic<size_t> errors(0);
+        std::vector<std::thread> readers;
+        for(size_t r = 0; r < 3; ++r){
+            readers.emplace_back([&]()
+            {
+                ContT::Reader reader(cont);
+                int val = 0;
+                while(!stop.load()){
+                    for(size_t i = 0; i < keys.size(); ++i){
+                        if(reader.find(keys[i], val) && static_cast<int>(i) != val)
+                            ++errors;
+                    }
+                }
+            });
+        }
+
+        for(size_t round = 0; round < 200; ++round){
+            for(size_t i = round % 2; i < keys.size(); i += 2)
+                cont.insert(keys[i], static_cast<int>(i));
+            for(size_t i = 0; i < keys.size(); i += 3)
+                cont.erase(keys[i]);
+            if(0 == round % 10)
+                cont.clear();
+        }
+        stop = true;
+        for(auto &t: readers)
+            t.join();
+        assert(0 == errors);
+    }
+
+    BOOST_AUTO_TEST_CASE(concurrentWritersTest_4Nodes)
+    {
+        typedef suffix_tree::ConcurrentSuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        ContT cont(ContT::TraitsT(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys()));
+        std::vector<ContT::ParsedKeyT> keys;
+        for(auto &k1: prepareLevel1Keys())
+            for(auto &k3: prepareLevel3Keys())
+                for(auto &k4: {std::string("dda"), std::string("ddz")})
+                    keys.push_back(cont.traits().parseKey(k1 + "-bbc-" + k3 + "-" + k4));
+
+        std::atomic<size_t> errors(0);
+        std::atomic<size_t> added(0);
+        std::vector<std::thread> writers;
+        for(size_t w = 0; w < 4; ++w){
+            writers.emplace_back([&, w]()
+            {
+                ContT::Reader reader(cont);
+                int val = 0;
+                /// every key is inserted by two writers
+                for(size_t i = 0; i < keys.size(); ++i){
+                    if(w / 2 != i % 2)
+                        continue;
+                    if(cont.insert(keys[i], static_cast<int>(i)))
+                        ++added;
+                    if(!reader.find(keys[i], val) || static_cast<int>(i) != val)
+                        ++errors;
+                }
+            });
+        }
+        for(auto &t: writers)
+            t.join();
+        assert(0 == errors);
+        assert(keys.size() == added);
+        assert(keys.size() == cont.size());
+        int val = 0;
+        for(size_t i = 0; i < keys.size(); ++i)
+            assert(cont.find(keys[i], val) && static_cast<int>(i) == val);
+    }
+
+    BOOST_AUTO_TEST_CASE(shardedTreeTest_4Nodes)
+    {
+        typedef suffix_tree::ShardedSuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        ContT cont(ContT::TraitsT(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys()), 4);
+        assert(4 == cont.shards());
+        assert(0 == cont.shardOf(cont.traits().parseKey("aaa-bba-cca-dda")));
+        assert(3 == cont.shardOf(cont.traits().parseKey("aaz-bba-cca-dda")));
+
+        assert(cont.insert("aaa-bba-cca-dda", 1).get().first);
+        assert(!cont.insert("aaa-bba-cca-dd?", 1).get().first);
+        auto res = cont.find("aaa-bba-cca-dda").get();
+        assert(res.first && 1 == res.second);
+        assert(!cont.find("aaa-bba-cca-ddb").get().first);
+        res = cont.erase("aaa-bba-cca-dda").get();
+        assert(res.first && 1 == res.second);
+        assert(!cont.erase("aaa-bba-cca-dda").get().first);
+        assert(0 == cont.size());
+    }
+
+    BOOST_AUTO_TEST_CASE(shardedTreeBatchTest_4Nodes)
+    {
+        typedef suffix_tree::ShardedSuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        ContT cont(ContT::TraitsT(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys()), 3, true, 0, 64);
+        std::vector<std::string> strKeys;
+        for(auto &k1: prepareLevel1Keys())
+            for(auto &k3: prepareLevel3Keys())
+                strKeys.push_back(k1 + "-bbc-" + k3 + "-ddd");
+        strKeys.push_back("aaa-bbc-ddd");
+        std::vector<ContT::KeyViewT> keys(std::begin(strKeys), std::end(strKeys));
+        std::vector<int> values(keys.size());
+        for(size_t i = 0; i < values.size(); ++i)
+            values[i] = static_cast<int>(i);
+
+        std::atomic<size_t> inserted(0);
+        size_t submitted = cont.submit_batch(ContT::insert_Op, keys.data(), values.data(), keys.size(),
+            [&](size_t, const ContT::ResultT &res){if(res.first) ++inserted;});
+        assert(keys.size() - 1 == submitted);
+        cont.flush();
+        assert(submitted == inserted);
+        assert(submitted == cont.size());
+
+        std::vector<int> found(keys.size(), -1);
+        cont.submit_batch(ContT::find_Op, keys.data(), nullptr, keys.size(),
+            [&](size_t idx, const ContT::ResultT &res){if(res.first) found[idx] = res.second;});
+        cont.flush();
+        for(size_t i = 0; i < submitted; ++i)
+            assert(values[i] == found[i]);
+        assert(-1 == found.back());
+    }
+
+    BOOST_AUTO_TEST_CASE(bulkInsertTest_4Nodes)
+    {
+        typedef suffix_tree::SuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        aux::SuffixTreeTraits<4, std::string, int> builder(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys());
+        typedef std::pair<std::string, int> KeyValueT;
+        std::vector<KeyValueT> keys;
+        int count = 0;
+        for(auto &k1: prepareLevel1Keys())
+            for(auto &k2: prepareLevel2Keys())
+                for(auto &k4: prepareLevel4Keys())
+                    keys.emplace_back(k1 + "-" + k2 + "-ccc-" + k4, count++);
+        /// new subkeys, malformed key and duplicate
+        keys.emplace_back("aa1-bbc-cc1-ddd", count++);
+        keys.emplace_back("aa2-bbc-cc1-ddd", count++);
+        keys.emplace_back("aaa-bbc-ddd", count++);
+        keys.emplace_back("aaa-bbc-ccc-ddd", count++);
+
+        ContT expected(builder);
+        for(auto &kv: keys)
+            expected.insert(kv.first, kv.second);
+
+        ContT cont(builder);
+        assert(keys.size() - 1 == cont.bulk_insert(std::begin(keys), std::end(keys), 4));
+        assert(expected.size() == cont.size());
+        auto itExpected = expected.begin();
+        for(auto it = cont.begin(); cont.end() != it; ++it, ++itExpected){
+            assert(expected.end() != itExpected);
+            assert(*itExpected == *it);
+        }
+        assert(expected.end() == itExpected);
+        assert(count - 1 == *cont.find("aaa-bbc-ccc-ddd"));
+        assert(cont.traits().parseKey("aa2-bbc-cc1-ddd") == expected.traits().parseKey("aa2-bbc-cc1-ddd"));
+
+        /// subtrees, which exist already, are updated by insert
+        std::vector<KeyValueT> more{{"aaa-bbc-ccc-ddd", -1}, {"aa3-bbc-ccc-ddd", -2}};
+        assert(2 == cont.bulk_insert(std::begin(more), std::end(more)));
+        assert(expected.size() + 1 == cont.size());
+        assert(-1 == *cont.find("aaa-bbc-ccc-ddd"));
+        assert(-2 == *cont.find("aa3-bbc-ccc-ddd"));
+        cont.erase("aa3-bbc-ccc-ddd");
+        cont.clear();
+        assert(0 == cont.size());
+        assert(keys.size() - 1 == cont.bulk_insert(std::begin(keys), std::end(keys), 3));
+        assert(expected.size() == cont.size());
+    }
+
+    BOOST_AUTO_TEST_CASE(parallelCopyTest_4Nodes)
+    {
+        typedef suffix_tree::SuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        ContT cont(ContT::TraitsT(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys()));
+        int count = 0;
+        for(auto &k1: prepareLevel1Keys())
+            for(auto &k3: prepareLevel3Keys())
+                for(auto &k4: {std::string("dda"), std::string("ddq")})
+                    cont.insert(k1 + "-bbc-" + k3 + "-" + k4, count++);
+
+        ContT copy(cont, 4);
+        assert(cont.size() == copy.size());
+        auto itCopy = copy.begin();
+        for(auto it = cont.begin(); cont.end() != it; ++it, ++itCopy){
+            assert(copy.end() != itCopy);
+            assert(*it == *itCopy);
+        }
+        assert(copy.end() == itCopy);
+
+        /// copy is independent from the source
+        copy.erase("aaa-bbc-cca-dda");
+        assert(cont.end() != cont.find("aaa-bbc-cca-dda"));
+        assert(copy.end() != copy.insert("aaa-bbc-cca-ddb", -1));
+        assert(cont.size() == copy.size());
+
+        copy.clear(4);
+        assert(0 == copy.size());
+        assert(copy.end() == copy.begin());
+        assert(copy.end() != copy.insert("aaa-bbc-cca-ddb", -1));
+        assert(-1 == *copy.find("aaa-bbc-cca-ddb"));
+
+        ContT emptyCopy(ContT(cont.traits()), 4);
+        assert(0 == emptyCopy.size());
+        assert(emptyCopy.end() == emptyCopy.begin());
+    }
+
+    BOOST_AUTO_TEST_CASE(treeReaperTest_4Nodes)
+    {
+        typedef suffix_tree::SuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        suffix_tree::TreeReaper reaper;
+        std::unique_ptr<ContT> cont(new ContT(ContT::TraitsT(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys())));
+        cont->setTeardownThreads(2);
+        for(auto &k1: prepareLevel1Keys())
+            for(auto &k4: prepareLevel4Keys())
+                cont->insert(k1 + "-bbc-ccc-" + k4, 1);
+        reaper.reap(std::move(cont));
+        assert(nullptr == cont);
+        reaper.reap(std::unique_ptr<ContT>());
+        reaper.wait();
+        assert(0 == reaper.pending());
+    }
+
+    BOOST_AUTO_TEST_CASE(snapshotTest_4Nodes)
+    {
+        const std::string path = "suffixTreeSnapshot.bin";
+        typedef suffix_tree::SuffixTree<aux::SuffixTreeTraits<4, std::string, int>> ContT;
+        ContT cont(ContT::TraitsT(prepareLevel1Keys(), prepareLevel2Keys(), prepareLevel3Keys(), prepareLevel4Keys()));
+        int count = 0;
+        for(auto &k1: prepareLevel1Keys())
+            for(auto &k3: prepareLevel3Keys())
+                cont.insert(k1 + "-bbc-" + k3 + "-ddq", count++);
+        cont.insert("aa1-bbc-cca-ddq", count++);
+        cont.save(path);
+
+        {
+            suffix_tree::MappedSuffixTree<4, int> mapped(path);
+            assert(cont.size() == mapped.size());
+            int val = -1;
+            assert(mapped.find("aa1-bbc-cca-ddq", val) && count - 1 == val);
+            assert(mapped.find("aab-bbc-cca-ddq", val) && 26 == val);
+            assert(!mapped.find("aab-bbc-cca-ddr", val));
+            assert(!mapped.find("aab-bbc-cca", val));
+            size_t visited = 0;
+            auto it = cont.begin();
+            mapped.forEach([&](const suffix_tree::MappedSuffixTree<4, int>::ParsedKeyT &key, int val)
+            {
+                assert(*it == val);
+                assert(cont.find(mapped.assembleKey(key)) == it);
+                ++it;
+                ++visited;
+            });
+            assert(cont.size() == visited);
+        }
+
+        /// subkeys of the snapshot are added to dictionaries of the loaded tree
+        ContT loaded((ContT::TraitsT()));
+        loaded.insert("zzz-zzz-zzz-zzz", -1);
+        loaded.load(path);
+        assert(cont.size() == loaded.size());
+        assert(loaded.end() == loaded.find("zzz-zzz-zzz-zzz"));
+        for(auto &k1: prepareLevel1Keys())
+            for(auto &k3: prepareLevel3Keys())
+                assert(*cont.find(k1 + "-bbc-" + k3 + "-ddq") == *loaded.find(k1 + "-bbc-" + k3 + "-ddq"));
+        assert(count - 1 == *loaded.find("aa1-bbc-cca-ddq"));
+
+        typedef suffix_tree::SuffixTree<aux::SuffixTreeTraits<3, std::string, int>> OtherContT;
+        OtherContT other((OtherContT::TraitsT()));
+        bool thrown = false;
+        try{
+            other.load(path);
+        }catch(const std::runtime_error &){
+            thrown = true;
+        }
+        assert(thrown);
+        std::remove(path.c_str());
+    }
 
 BOOST_AUTO_TEST_SUITE_END()
 
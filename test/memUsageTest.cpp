@@ -41,7 +41,7 @@ namespace tst{
                     cont,
                     [](ContT &cont, const std::string &k, const int &value)->void
                     {
-                        auto it = cont.insert(k.c_str(), value);
+                        auto it = cont.insert(k, value);
 
                         assert(value == cont.size());
                         assert(cont.end() != it);
@@ -55,7 +55,7 @@ namespace tst{
                     cont,
                     [](ContT &cont, const std::string &k, const int &value)->void
                     {
-                        auto it = cont.find(k.c_str());
+                        auto it = cont.find(k);
                         assert(cont.end() != it);
                         assert(value == *it);
                     },
@@ -85,7 +85,7 @@ namespace tst{
                     cont,
                     [](ContT &cont, const std::string &k, const int &value)->void
                     {
-                        auto it = cont.insert(k.c_str(), value);
+                        auto it = cont.insert(k, value);
 
                         assert(value == cont.size());
                         assert(cont.end() != it);
@@ -99,7 +99,7 @@ namespace tst{
                     cont,
                     [](ContT &cont, const std::string& k, const int &value)->void
                     {
-                        auto it = cont.find(k.c_str());
+                        auto it = cont.find(k);
                         assert(cont.end() != it);
                         assert(value == *it);
                     },
@@ -171,7 +171,7 @@ namespace tst{
                 {
                     ComplexKey complexKey;
                     aux::SuffixTreeTraits<4, std::string, int>::ParsedKeyT parsedKey;
-                    if(!builder.parseKey(k.c_str(), parsedKey))
+                    if(!builder.parseKey(k, parsedKey))
                         throw std::runtime_error("Unable to parse string key to indexes");
                     complexKey.idx1_ = parsedKey[0];
                     complexKey.idx2_ = parsedKey[1];
@@ -190,7 +190,7 @@ namespace tst{
                 {
                     ComplexKey complexKey;
                     aux::SuffixTreeTraits<4, std::string, int>::ParsedKeyT parsedKey;
-                    if(!builder.parseKey(k.c_str(), parsedKey))
+                    if(!builder.parseKey(k, parsedKey))
                         throw std::runtime_error("Unable to parse string key to indexes");
                     complexKey.idx1_ = parsedKey[0];
                     complexKey.idx2_ = parsedKey[1];
@@ -281,7 +281,7 @@ namespace tst{
                 {
                     ComplexKey complexKey;
                     aux::SuffixTreeTraits<4, std::string, int>::ParsedKeyT parsedKey;
-                    if(!builder.parseKey(k.c_str(), parsedKey))
+                    if(!builder.parseKey(k, parsedKey))
                         throw std::runtime_error("Unable to parse string key to indexes");
                     complexKey.idx1_ = parsedKey[0];
                     complexKey.idx2_ = parsedKey[1];
@@ -304,7 +304,7 @@ namespace tst{
                 {
                     ComplexKey complexKey;
                     aux::SuffixTreeTraits<4, std::string, int>::ParsedKeyT parsedKey;
-                    if(!builder.parseKey(k.c_str(), parsedKey))
+                    if(!builder.parseKey(k, parsedKey))
                         throw std::runtime_error("Unable to parse string key to indexes");
                     complexKey.idx1_ = parsedKey[0];
                     complexKey.idx2_ = parsedKey[1];
@@ -348,7 +348,7 @@ namespace tst{
                 cont,
                 [](ContT &cont, const std::string &k, const int &value)->void
                 {
-                    auto it = cont.insert(k.c_str(), value);
+                    auto it = cont.insert(k, value);
 
                     assert(value == cont.size());
                     assert(cont.end() != it);
@@ -361,7 +361,7 @@ namespace tst{
                 cont,
                 [](ContT &cont, const std::string &k, const int &value)->void
                 {
-                    auto it = cont.find(k.c_str());
+                    auto it = cont.find(k);
                     assert(cont.end() != it);
                     assert(value == *it);
                 },